@@ -0,0 +1,290 @@
+/******************************************************************************/
+/*                                                                            */
+/*                   Fast Object Formatter Extension (objutil)                */
+/*                                                                            */
+/* DESCRIPTION:                                                               */
+/* Buffered text, JSON lines and CSV output for objects. See objfmt.h.       */
+/*                                                                            */
+/* Copyright (c) 2026, Nico Fontani                                           */
+/* Creation Date: 19 Oct 2026                                                 */
+/*                                                                            */
+/* Original Author: Nico Fontani                                              */
+/* Last Modified: 19 Oct 2026                                                 */
+/*                                                                            */
+/* Supported by GCC and POSIX (writev)                                        */
+/*                                                                            */
+/******************************************************************************/
+
+#include <errno.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+#include "objfmt.h"
+
+/* Objects read per objstore read section in obj_dump_all() */
+#define DUMP_BATCH 4096
+
+/* "00" "01" ... "99": two decimal digits per lookup */
+static const char digit_pairs[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+/* Number of decimal digits of v */
+static int fmt_digits(uint32_t v) {
+    int n = 1;
+    while (v >= 10000) { v /= 10000; n += 4; }
+    if (v >= 1000) return n + 3;
+    if (v >= 100) return n + 2;
+    if (v >= 10) return n + 1;
+    return n;
+}
+
+/* Write an unsigned integer at p, return the end */
+static char* fmt_u32(char* p, uint32_t v) {
+    char* end = p + fmt_digits(v);
+    char* q = end;
+    while (v >= 100) {
+        uint32_t r = v % 100;
+        v /= 100;
+        q -= 2;
+        memcpy(q, digit_pairs + r * 2, 2);
+    }
+    if (v >= 10) {
+        q -= 2;
+        memcpy(q, digit_pairs + v * 2, 2);
+    } else {
+        *--q = (char)('0' + v);
+    }
+    return end;
+}
+
+/* Write a signed integer at p, return the end */
+static char* fmt_i32(char* p, int v) {
+    if (v < 0) {
+        *p++ = '-';
+        return fmt_u32(p, 0u - (uint32_t)v);
+    }
+    return fmt_u32(p, (uint32_t)v);
+}
+
+/* Copy a literal string at p, return the end */
+static char* fmt_str(char* p, const char* s, size_t len) {
+    memcpy(p, s, len);
+    return p + len;
+}
+#define FMT_LIT(p, lit) fmt_str((p), (lit), sizeof(lit) - 1)
+
+/* Write a JSON string body (without quotes) */
+static char* fmt_json_escape(char* p, const char* s) {
+    static const char hex[] = "0123456789abcdef";
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            *p++ = '\\';
+            *p++ = (char)c;
+        } else if (c < 0x20) {
+            p = FMT_LIT(p, "\\u00");
+            *p++ = hex[c >> 4];
+            *p++ = hex[c & 15];
+        } else {
+            *p++ = (char)c;
+        }
+    }
+    return p;
+}
+
+/* Write a CSV field, quoted only when needed */
+static char* fmt_csv_field(char* p, const char* s) {
+    if (!strpbrk(s, ",\"\r\n")) return fmt_str(p, s, strlen(s));
+    *p++ = '"';
+    for (; *s; s++) {
+        if (*s == '"') *p++ = '"';
+        *p++ = *s;
+    }
+    *p++ = '"';
+    return p;
+}
+
+/* Upper bound of the bytes needed to format an object */
+static size_t fmt_bound(const Object* obj) {
+    size_t name = obj->name ? strlen(obj->name) : 0;
+    return name * 6 + 64 + MAX_ATTRIBUTES * 32;
+}
+
+/* Format one object at p, return the end */
+static char* fmt_object(char* p, const Object* obj, ObjFormat format) {
+    const char* name = obj->name ? obj->name : "";
+    int n = obj->num_attributes;
+    if (n < 0) n = 0;
+    if (n > MAX_ATTRIBUTES) n = MAX_ATTRIBUTES;
+
+    switch (format) {
+    case OBJ_FMT_JSONL:
+        p = FMT_LIT(p, "{\"name\":\"");
+        p = fmt_json_escape(p, name);
+        p = FMT_LIT(p, "\",\"attributes\":[");
+        for (int i = 0; i < n; i++) {
+            if (i) *p++ = ',';
+            p = fmt_i32(p, obj->attributes[i]);
+        }
+        p = FMT_LIT(p, "]}\n");
+        break;
+
+    case OBJ_FMT_CSV:
+        p = fmt_csv_field(p, name);
+        for (int i = 0; i < MAX_ATTRIBUTES; i++) {
+            *p++ = ',';
+            if (i < n) p = fmt_i32(p, obj->attributes[i]);
+        }
+        *p++ = '\n';
+        break;
+
+    case OBJ_FMT_TEXT:
+    default:
+        p = FMT_LIT(p, "Object: ");
+        p = fmt_str(p, name, strlen(name));
+        p = FMT_LIT(p, "\nAttributes:\n");
+        for (int i = 0; i < n; i++) {
+            p = FMT_LIT(p, "  Attribute ");
+            p = fmt_i32(p, i);
+            p = FMT_LIT(p, ": ");
+            p = fmt_i32(p, obj->attributes[i]);
+            *p++ = '\n';
+        }
+        break;
+    }
+    return p;
+}
+
+/* Write an I/O vector completely, retrying on short writes */
+static int buf_writev_all(int fd, struct iovec* iov, int iovcnt) {
+    while (iovcnt > 0) {
+        ssize_t n = writev(fd, iov, iovcnt);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        while (iovcnt > 0 && (size_t)n >= iov->iov_len) {
+            n -= (ssize_t)iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = (char*)iov->iov_base + n;
+            iov->iov_len -= (size_t)n;
+        }
+    }
+    return 0;
+}
+
+/* Prepare a buffer */
+int obj_buf_init(ObjBuf* buf, int fd, ObjFormat format) {
+    buf->data = malloc((size_t)OBJ_BUF_CHUNKS * OBJ_BUF_CHUNK);
+    if (!buf->data) return -1;
+    buf->fd = fd;
+    buf->format = format;
+    buf->chunk = 0;
+    buf->error = 0;
+    memset(buf->used, 0, sizeof(buf->used));
+    return 0;
+}
+
+/* Write everything buffered so far with one writev() */
+int obj_buf_flush(ObjBuf* buf) {
+    struct iovec iov[OBJ_BUF_CHUNKS];
+    int iovcnt = 0;
+
+    for (int c = 0; c <= buf->chunk; c++) {
+        if (buf->used[c] == 0) continue;
+        iov[iovcnt].iov_base = buf->data + (size_t)c * OBJ_BUF_CHUNK;
+        iov[iovcnt].iov_len = buf->used[c];
+        iovcnt++;
+    }
+    memset(buf->used, 0, sizeof(buf->used));
+    buf->chunk = 0;
+
+    if (buf->error) return -1;
+    if (buf_writev_all(buf->fd, iov, iovcnt) != 0) {
+        buf->error = errno;
+        return -1;
+    }
+    return 0;
+}
+
+/* Flush and release the buffer */
+int obj_buf_free(ObjBuf* buf) {
+    int ret = obj_buf_flush(buf);
+    free(buf->data);
+    buf->data = NULL;
+    return ret;
+}
+
+/* Room for `need` contiguous bytes, or NULL if the record must bypass the buffer */
+static char* buf_reserve(ObjBuf* buf, size_t need) {
+    if (need > OBJ_BUF_CHUNK) return NULL;
+    if (OBJ_BUF_CHUNK - buf->used[buf->chunk] < need) {
+        if (buf->chunk + 1 == OBJ_BUF_CHUNKS) obj_buf_flush(buf);
+        else buf->chunk++;
+    }
+    return buf->data + (size_t)buf->chunk * OBJ_BUF_CHUNK + buf->used[buf->chunk];
+}
+
+/* Write the CSV header row */
+int obj_format_header(ObjBuf* buf) {
+    if (buf->format != OBJ_FMT_CSV) return 0;
+
+    char* start = buf_reserve(buf, 16 + MAX_ATTRIBUTES * 16);
+    char* p = FMT_LIT(start, "name");
+    for (int i = 0; i < MAX_ATTRIBUTES; i++) {
+        p = FMT_LIT(p, ",attr");
+        p = fmt_i32(p, i);
+    }
+    *p++ = '\n';
+    buf->used[buf->chunk] += (size_t)(p - start);
+    return buf->error ? -1 : 0;
+}
+
+/* Append one object */
+int obj_format_to(ObjBuf* buf, const Object* obj) {
+    size_t need = fmt_bound(obj);
+    char* start = buf_reserve(buf, need);
+
+    if (!start) {
+        /* Larger than a chunk (very long name): write it on its own */
+        if (obj_buf_flush(buf) != 0) return -1;
+        char* tmp = malloc(need);
+        if (!tmp) return -1;
+        struct iovec iov = { tmp, (size_t)(fmt_object(tmp, obj, buf->format) - tmp) };
+        int ret = buf_writev_all(buf->fd, &iov, 1);
+        if (ret != 0) buf->error = errno;
+        free(tmp);
+        return ret;
+    }
+
+    buf->used[buf->chunk] += (size_t)(fmt_object(start, obj, buf->format) - start);
+    return buf->error ? -1 : 0;
+}
+
+/* Dump every object of a store */
+int obj_dump_all(ObjStore* store, int tid, int fd, ObjFormat format) {
+    ObjBuf buf;
+    if (obj_buf_init(&buf, fd, format) != 0) return -1;
+    obj_format_header(&buf);
+
+    /* Short read sections, so a long dump does not hold back reclamation */
+    for (size_t base = 0; base < store->capacity && !buf.error; base += DUMP_BATCH) {
+        size_t end = (store->capacity - base < DUMP_BATCH) ? store->capacity : base + DUMP_BATCH;
+        objstore_enter(store, tid);
+        for (size_t id = base; id < end; id++) {
+            ObjStoreEntry* entry = objstore_lookup(store, id);
+            if (!entry) continue;
+            Object copy;
+            objstore_read_entry(entry, &copy);
+            obj_format_to(&buf, &copy);
+        }
+        objstore_exit(store, tid);
+    }
+
+    return obj_buf_free(&buf);
+}
@@ -0,0 +1,71 @@
+/******************************************************************************/
+/*                                                                            */
+/*                   Fast Object Formatter Extension (objutil)                */
+/*                                                                            */
+/* DESCRIPTION:                                                               */
+/* This extension formats objects into a large reusable buffer and writes it  */
+/* to a file descriptor with writev(), instead of one printf() per line.      */
+/* Integers are converted with a two-digits-at-a-time lookup table.           */
+/* Three output formats are available: the obj_print() text layout,           */
+/* JSON lines and CSV.                                                        */
+/*                                                                            */
+/* Copyright (c) 2026, Nico Fontani                                           */
+/* Creation Date: 19 Oct 2026                                                 */
+/*                                                                            */
+/* Original Author: Nico Fontani                                              */
+/* Last Modified: 19 Oct 2026                                                 */
+/*                                                                            */
+/* Supported by GCC and POSIX (writev)                                        */
+/*                                                                            */
+/******************************************************************************/
+
+#ifndef OBJFMT_H
+#define OBJFMT_H
+
+#include <stddef.h>
+
+#include "objutil.h"
+#include "objstore.h"
+
+#define OBJ_BUF_CHUNK  (256 * 1024)   /* Bytes per buffer chunk            */
+#define OBJ_BUF_CHUNKS 16             /* Chunks written by a single writev */
+
+/* Output formats */
+typedef enum {
+    OBJ_FMT_TEXT,    /* Same layout as obj_print()                          */
+    OBJ_FMT_JSONL,   /* {"name":"...","attributes":[...]} one per line       */
+    OBJ_FMT_CSV      /* name,attr0,...,attrN with a header row              */
+} ObjFormat;
+
+/* Output buffer bound to a file descriptor */
+typedef struct {
+    int       fd;
+    ObjFormat format;
+    char*     data;                       /* OBJ_BUF_CHUNKS * OBJ_BUF_CHUNK   */
+    size_t    used[OBJ_BUF_CHUNKS];       /* Bytes filled in each chunk       */
+    int       chunk;                      /* Chunk being filled               */
+    int       error;                      /* errno of the first failed write  */
+} ObjBuf;
+
+/* Function prototypes */
+
+/* Prepare a buffer writing to `fd`. Returns 0, or -1 if memory is exhausted */
+int obj_buf_init(ObjBuf* buf, int fd, ObjFormat format);
+
+/* Write everything buffered so far. Returns 0, or -1 on write error */
+int obj_buf_flush(ObjBuf* buf);
+
+/* Flush and release the buffer. Returns the result of the final flush */
+int obj_buf_free(ObjBuf* buf);
+
+/* Write the CSV header row (only meaningful for OBJ_FMT_CSV) */
+int obj_format_header(ObjBuf* buf);
+
+/* Append one object in the buffer's format. Returns 0, or -1 on write error */
+int obj_format_to(ObjBuf* buf, const Object* obj);
+
+/* Dump every object of a store to `fd`, reading it without blocking writers.
+   `tid` is the caller's objstore thread id. Returns 0, or -1 on error */
+int obj_dump_all(ObjStore* store, int tid, int fd, ObjFormat format);
+
+#endif /* OBJFMT_H */
@@ -0,0 +1,153 @@
+/******************************************************************************/
+/*                                                                            */
+/*                   Object Pool Extension (objutil lifecycle)                */
+/*                                                                            */
+/* DESCRIPTION:                                                               */
+/* Free-list object pool with generation-tagged handles. See objpool.h.      */
+/*                                                                            */
+/* Copyright (c) 2026, Nico Fontani                                           */
+/* Creation Date: 19 Oct 2026                                                 */
+/*                                                                            */
+/* Original Author: Nico Fontani                                              */
+/* Last Modified: 19 Oct 2026                                                 */
+/*                                                                            */
+/* Supported by C Programming                                                 */
+/*                                                                            */
+/******************************************************************************/
+
+#include "objpool.h"
+
+#define OBJ_POOL_NONE 0xFFFFFFFFu   /* End of the free list */
+#define OBJ_POOL_LIVE 0xFFFFFFFEu   /* Marks an acquired slot */
+
+/* Slot at a given index */
+static ObjPoolSlot* pool_slot(ObjPool* pool, uint32_t index) {
+    return &pool->chunks[index / OBJ_POOL_CHUNK][index % OBJ_POOL_CHUNK];
+}
+
+/* Add one chunk of free slots. Returns 0 on success, -1 on failure */
+static int pool_grow(ObjPool* pool) {
+    if ((pool->n_chunks + 1) * (uint64_t)OBJ_POOL_CHUNK >= OBJ_POOL_LIVE) return -1;
+
+    if (pool->n_chunks == pool->cap_chunks) {
+        size_t cap = pool->cap_chunks ? pool->cap_chunks * 2 : 8;
+        ObjPoolSlot** chunks = realloc(pool->chunks, cap * sizeof(ObjPoolSlot*));
+        if (!chunks) return -1;
+        pool->chunks = chunks;
+        pool->cap_chunks = cap;
+    }
+
+    ObjPoolSlot* chunk = malloc(OBJ_POOL_CHUNK * sizeof(ObjPoolSlot));
+    if (!chunk) return -1;
+
+    /* Thread the new slots onto the free list, lowest index first */
+    uint32_t base = (uint32_t)(pool->n_chunks * OBJ_POOL_CHUNK);
+    for (uint32_t i = 0; i < OBJ_POOL_CHUNK; i++) {
+        chunk[i].obj.name = NULL;
+        chunk[i].obj.num_attributes = 0;
+        chunk[i].generation = 0;
+        chunk[i].next_free = (i + 1 < OBJ_POOL_CHUNK) ? base + i + 1 : pool->free_head;
+    }
+    pool->chunks[pool->n_chunks++] = chunk;
+    pool->free_head = base;
+    return 0;
+}
+
+/* Slot behind a handle, or NULL if the handle is stale or invalid */
+static ObjPoolSlot* pool_lookup(ObjPool* pool, ObjHandle handle) {
+    uint32_t low = (uint32_t)handle;
+    if (low == 0 || (size_t)(low - 1) >= pool->n_chunks * OBJ_POOL_CHUNK) return NULL;
+
+    ObjPoolSlot* slot = pool_slot(pool, low - 1);
+    if (slot->next_free != OBJ_POOL_LIVE || slot->generation != (uint32_t)(handle >> 32)) {
+        return NULL;
+    }
+    return slot;
+}
+
+/* Free a name that did not fit in the slot */
+static void pool_drop_name(ObjPoolSlot* slot) {
+    if (slot->obj.name != slot->name_buf) free(slot->obj.name);
+    slot->obj.name = NULL;
+}
+
+/* Create a pool */
+ObjPool* obj_pool_create(size_t initial_capacity) {
+    ObjPool* pool = malloc(sizeof(ObjPool));
+    if (!pool) return NULL;
+
+    pool->chunks = NULL;
+    pool->n_chunks = 0;
+    pool->cap_chunks = 0;
+    pool->free_head = OBJ_POOL_NONE;
+    pool->in_use = 0;
+
+    do {
+        if (pool_grow(pool) != 0) {
+            obj_pool_destroy(pool);
+            return NULL;
+        }
+    } while (pool->n_chunks * OBJ_POOL_CHUNK < initial_capacity);
+    return pool;
+}
+
+/* Destroy a pool */
+void obj_pool_destroy(ObjPool* pool) {
+    if (!pool) return;
+
+    for (size_t c = 0; c < pool->n_chunks; c++) {
+        for (size_t i = 0; i < OBJ_POOL_CHUNK; i++) {
+            if (pool->chunks[c][i].next_free == OBJ_POOL_LIVE) pool_drop_name(&pool->chunks[c][i]);
+        }
+        free(pool->chunks[c]);
+    }
+    free(pool->chunks);
+    free(pool);
+}
+
+/* Acquire an initialized object */
+ObjHandle obj_pool_acquire(ObjPool* pool, const char* name) {
+    if (pool->free_head == OBJ_POOL_NONE && pool_grow(pool) != 0) return OBJ_HANDLE_NULL;
+
+    uint32_t index = pool->free_head;
+    ObjPoolSlot* slot = pool_slot(pool, index);
+
+    /* Short names go in the slot, long ones on the heap */
+    size_t len = strlen(name);
+    if (len < OBJ_POOL_NAME_LEN) {
+        memcpy(slot->name_buf, name, len + 1);
+        slot->obj.name = slot->name_buf;
+    } else {
+        slot->obj.name = strdup(name);
+        if (!slot->obj.name) return OBJ_HANDLE_NULL;
+    }
+
+    pool->free_head = slot->next_free;
+    slot->next_free = OBJ_POOL_LIVE;
+    slot->obj.num_attributes = 0;
+    memset(slot->obj.attributes, 0, sizeof(slot->obj.attributes));
+    pool->in_use++;
+
+    return ((ObjHandle)slot->generation << 32) | (ObjHandle)(index + 1);
+}
+
+/* Release an object back to the pool */
+int obj_pool_release(ObjPool* pool, ObjHandle handle) {
+    ObjPoolSlot* slot = pool_lookup(pool, handle);
+    if (!slot) return -1;
+
+    uint32_t index = (uint32_t)handle - 1;
+    pool_drop_name(slot);
+    slot->obj.num_attributes = 0;
+    slot->generation++;             /* Invalidates every outstanding handle */
+    slot->next_free = pool->free_head;
+    pool->free_head = index;        /* LIFO reuse keeps recently used slots hot */
+    pool->in_use--;
+    return 0;
+}
+
+/* Resolve a handle */
+Object* obj_pool_get(ObjPool* pool, ObjHandle handle) {
+    ObjPoolSlot* slot = pool_lookup(pool, handle);
+    return slot ? &slot->obj : NULL;
+}
@@ -0,0 +1,81 @@
+/******************************************************************************/
+/*                                                                            */
+/*                   Object Pool Extension (objutil lifecycle)                */
+/*                                                                            */
+/* DESCRIPTION:                                                               */
+/* This extension recycles objects instead of allocating and freeing them     */
+/* one by one. Objects live in chunks that are never returned to the heap     */
+/* while the pool exists (type-stable memory), released slots go back on a    */
+/* free list, and short names are stored inline in the slot.                  */
+/* Objects are addressed through generation-tagged handles, so a handle to a  */
+/* released object is detected with a single comparison.                      */
+/* A pool is not thread-safe: use one pool per thread or lock around it.      */
+/* Pooled objects go back only through obj_pool_release(), never through      */
+/* obj_destroy(): their name may live inside the slot, not on the heap.       */
+/*                                                                            */
+/* Copyright (c) 2026, Nico Fontani                                           */
+/* Creation Date: 19 Oct 2026                                                 */
+/*                                                                            */
+/* Original Author: Nico Fontani                                              */
+/* Last Modified: 19 Oct 2026                                                 */
+/*                                                                            */
+/* Supported by C Programming                                                 */
+/*                                                                            */
+/******************************************************************************/
+
+#ifndef OBJPOOL_H
+#define OBJPOOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "objutil.h"
+
+#define OBJ_POOL_NAME_LEN 32     /* Names shorter than this are stored inline */
+#define OBJ_POOL_CHUNK    4096   /* Slots allocated at a time                 */
+
+/* Handle to a pooled object: generation in the high 32 bits, slot index + 1
+   in the low 32 bits. 0 is never a valid handle */
+typedef uint64_t ObjHandle;
+#define OBJ_HANDLE_NULL ((ObjHandle)0)
+
+/* One recyclable slot */
+typedef struct {
+    Object   obj;
+    uint32_t generation;               /* Bumped every time the slot is released */
+    uint32_t next_free;                /* Free-list link, OBJ_POOL_LIVE if in use */
+    char     name_buf[OBJ_POOL_NAME_LEN];
+} ObjPoolSlot;
+
+/* The pool itself */
+typedef struct {
+    ObjPoolSlot** chunks;      /* Chunks of OBJ_POOL_CHUNK slots            */
+    size_t        n_chunks;
+    size_t        cap_chunks;
+    uint32_t      free_head;   /* First free slot, OBJ_POOL_NONE if empty   */
+    size_t        in_use;      /* Number of acquired objects                */
+} ObjPool;
+
+/* Function prototypes */
+
+/* Create a pool with room for at least `initial_capacity` objects.
+   Returns NULL if memory is exhausted */
+ObjPool* obj_pool_create(size_t initial_capacity);
+
+/* Destroy a pool and every object still acquired from it */
+void obj_pool_destroy(ObjPool* pool);
+
+/* Acquire an initialized object (as obj_init) and return its handle,
+   or OBJ_HANDLE_NULL if memory is exhausted */
+ObjHandle obj_pool_acquire(ObjPool* pool, const char* name);
+
+/* Release an object back to the pool.
+   Returns 0 on success, -1 if the handle is stale or invalid */
+int obj_pool_release(ObjPool* pool, ObjHandle handle);
+
+/* Resolve a handle. Returns NULL if the handle is stale or invalid.
+   The pointer stays valid until the object is released; the object is owned
+   by the pool: release it with obj_pool_release(), never obj_destroy() */
+Object* obj_pool_get(ObjPool* pool, ObjHandle handle);
+
+#endif /* OBJPOOL_H */
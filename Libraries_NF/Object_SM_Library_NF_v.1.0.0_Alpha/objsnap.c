@@ -0,0 +1,381 @@
+/******************************************************************************/
+/*                                                                            */
+/*                 Object Snapshot Extension (objutil binary files)           */
+/*                                                                            */
+/* DESCRIPTION:                                                               */
+/* Writer and mmap()-based reader for objutil snapshot files. See objsnap.h   */
+/* for the file layout.                                                       */
+/*                                                                            */
+/* Copyright (c) 2026, Nico Fontani                                           */
+/* Creation Date: 19 Oct 2026                                                 */
+/*                                                                            */
+/* Original Author: Nico Fontani                                              */
+/* Last Modified: 19 Oct 2026                                                 */
+/*                                                                            */
+/* Supported by GCC and POSIX (mmap)                                          */
+/*                                                                            */
+/******************************************************************************/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "objsnap.h"
+
+/* Number of values converted at a time when writing a column */
+#define SNAP_CHUNK 4096
+
+/* Byte order helpers: the file is little-endian, the host may not be */
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+static uint32_t snap_le32(uint32_t v) { return __builtin_bswap32(v); }
+static uint64_t snap_le64(uint64_t v) { return __builtin_bswap64(v); }
+#else
+static uint32_t snap_le32(uint32_t v) { return v; }
+static uint64_t snap_le64(uint64_t v) { return v; }
+#endif
+
+/* Round `v` up to the next multiple of OBJ_SNAP_ALIGN */
+static uint64_t snap_align(uint64_t v) {
+    return (v + OBJ_SNAP_ALIGN - 1) & ~(uint64_t)(OBJ_SNAP_ALIGN - 1);
+}
+
+/* FNV-1a hash, used to intern names */
+static uint64_t snap_hash(const char* s) {
+    uint64_t h = 1469598103934665603ULL;
+    while (*s) {
+        h ^= (unsigned char)*s++;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+/* Write `len` zero bytes */
+static int snap_pad(FILE* f, uint64_t len) {
+    static const char zeros[256];
+    while (len > 0) {
+        size_t n = len < sizeof(zeros) ? (size_t)len : sizeof(zeros);
+        if (fwrite(zeros, 1, n, f) != n) return -1;
+        len -= n;
+    }
+    return 0;
+}
+
+/* Intern the names of `objs`: fills ids[] (one per object) and unique[]
+   (one per distinct name). Returns the number of distinct names, or
+   (size_t)-1 if memory is exhausted */
+static size_t snap_intern(const Object* objs, size_t count,
+                          uint32_t* ids, const char** unique) {
+    size_t cap = 16;
+    while (cap < count * 2) cap <<= 1;
+
+    uint32_t* table = malloc(cap * sizeof(uint32_t));  /* 0 = empty, else id + 1 */
+    if (!table) return (size_t)-1;
+    memset(table, 0, cap * sizeof(uint32_t));
+
+    size_t n_unique = 0;
+    for (size_t i = 0; i < count; i++) {
+        const char* name = objs[i].name ? objs[i].name : "";
+        size_t slot = snap_hash(name) & (cap - 1);
+        while (table[slot] && strcmp(unique[table[slot] - 1], name) != 0) {
+            slot = (slot + 1) & (cap - 1);
+        }
+        if (!table[slot]) {
+            unique[n_unique++] = name;
+            table[slot] = (uint32_t)n_unique;
+        }
+        ids[i] = table[slot] - 1;
+    }
+
+    free(table);
+    return n_unique;
+}
+
+/* Write the sections of a snapshot whose layout is already in `hdr` */
+static int snap_write_body(FILE* f, const ObjSnapHeader* hdr, const Object* objs,
+                           size_t count, const uint32_t* ids,
+                           const char** unique, size_t n_unique) {
+    uint32_t buf32[SNAP_CHUNK];
+    uint64_t buf64[SNAP_CHUNK];
+    uint64_t pos = sizeof(ObjSnapHeader);
+
+    /* Name offsets */
+    if (snap_pad(f, hdr->sections[OBJ_SNAP_NAME_OFFSETS].offset - pos)) return -1;
+    uint64_t blob_pos = 0;
+    for (size_t i = 0; i < n_unique; i += SNAP_CHUNK) {
+        size_t n = (n_unique - i < SNAP_CHUNK) ? n_unique - i : SNAP_CHUNK;
+        for (size_t j = 0; j < n; j++) {
+            buf64[j] = snap_le64(blob_pos);
+            blob_pos += strlen(unique[i + j]) + 1;
+        }
+        if (fwrite(buf64, sizeof(uint64_t), n, f) != n) return -1;
+    }
+    pos = hdr->sections[OBJ_SNAP_NAME_OFFSETS].offset + n_unique * sizeof(uint64_t);
+
+    /* Name blob */
+    if (snap_pad(f, hdr->sections[OBJ_SNAP_NAME_BLOB].offset - pos)) return -1;
+    for (size_t i = 0; i < n_unique; i++) {
+        size_t len = strlen(unique[i]) + 1;
+        if (fwrite(unique[i], 1, len, f) != len) return -1;
+    }
+    pos = hdr->sections[OBJ_SNAP_NAME_BLOB].offset + blob_pos;
+
+    /* Name ids */
+    if (snap_pad(f, hdr->sections[OBJ_SNAP_NAME_IDS].offset - pos)) return -1;
+    for (size_t i = 0; i < count; i += SNAP_CHUNK) {
+        size_t n = (count - i < SNAP_CHUNK) ? count - i : SNAP_CHUNK;
+        for (size_t j = 0; j < n; j++) buf32[j] = snap_le32(ids[i + j]);
+        if (fwrite(buf32, sizeof(uint32_t), n, f) != n) return -1;
+    }
+    pos = hdr->sections[OBJ_SNAP_NAME_IDS].offset + count * sizeof(uint32_t);
+
+    /* Number of attributes */
+    if (snap_pad(f, hdr->sections[OBJ_SNAP_NUM_ATTRS].offset - pos)) return -1;
+    for (size_t i = 0; i < count; i += SNAP_CHUNK) {
+        size_t n = (count - i < SNAP_CHUNK) ? count - i : SNAP_CHUNK;
+        for (size_t j = 0; j < n; j++) buf32[j] = snap_le32((uint32_t)objs[i + j].num_attributes);
+        if (fwrite(buf32, sizeof(uint32_t), n, f) != n) return -1;
+    }
+    pos = hdr->sections[OBJ_SNAP_NUM_ATTRS].offset + count * sizeof(uint32_t);
+
+    /* Attribute columns, each padded to column_stride */
+    for (int a = 0; a < MAX_ATTRIBUTES; a++) {
+        uint64_t col = hdr->sections[OBJ_SNAP_ATTRS].offset + (uint64_t)a * hdr->column_stride;
+        if (snap_pad(f, col - pos)) return -1;
+        for (size_t i = 0; i < count; i += SNAP_CHUNK) {
+            size_t n = (count - i < SNAP_CHUNK) ? count - i : SNAP_CHUNK;
+            for (size_t j = 0; j < n; j++) buf32[j] = snap_le32((uint32_t)objs[i + j].attributes[a]);
+            if (fwrite(buf32, sizeof(uint32_t), n, f) != n) return -1;
+        }
+        pos = col + count * sizeof(uint32_t);
+    }
+
+    return snap_pad(f, hdr->file_size - pos);
+}
+
+/* Write `count` objects to a snapshot file */
+int obj_snapshot_write(const char* path, const Object* objs, size_t count) {
+    if (!path || (!objs && count > 0) || count > UINT32_MAX) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    uint32_t* ids = malloc((count ? count : 1) * sizeof(uint32_t));
+    const char** unique = malloc((count ? count : 1) * sizeof(char*));
+    if (!ids || !unique) {
+        free(ids);
+        free(unique);
+        errno = ENOMEM;
+        return -1;
+    }
+    size_t n_unique = snap_intern(objs, count, ids, unique);
+    if (n_unique == (size_t)-1) {
+        free(ids);
+        free(unique);
+        errno = ENOMEM;
+        return -1;
+    }
+
+    uint64_t blob_size = 0;
+    for (size_t i = 0; i < n_unique; i++) blob_size += strlen(unique[i]) + 1;
+
+    /* Lay out the sections, each one page-aligned */
+    ObjSnapHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    uint64_t sizes[OBJ_SNAP_NSECTIONS];
+    hdr.column_stride = snap_align(count * sizeof(uint32_t));
+    sizes[OBJ_SNAP_NAME_OFFSETS] = n_unique * sizeof(uint64_t);
+    sizes[OBJ_SNAP_NAME_BLOB]    = blob_size;
+    sizes[OBJ_SNAP_NAME_IDS]     = count * sizeof(uint32_t);
+    sizes[OBJ_SNAP_NUM_ATTRS]    = count * sizeof(uint32_t);
+    sizes[OBJ_SNAP_ATTRS]        = hdr.column_stride * MAX_ATTRIBUTES;
+
+    uint64_t off = snap_align(sizeof(ObjSnapHeader));
+    for (int s = 0; s < OBJ_SNAP_NSECTIONS; s++) {
+        hdr.sections[s].offset = off;
+        hdr.sections[s].size = sizes[s];
+        off = snap_align(off + sizes[s]);
+    }
+    hdr.num_objects = count;
+    hdr.num_names = n_unique;
+    hdr.file_size = off;
+
+    /* Header as stored on disk */
+    ObjSnapHeader disk;
+    memset(&disk, 0, sizeof(disk));
+    memcpy(disk.magic, OBJ_SNAP_MAGIC, sizeof(disk.magic));
+    disk.version = snap_le32(OBJ_SNAP_VERSION);
+    disk.header_size = snap_le32(sizeof(ObjSnapHeader));
+    disk.align = snap_le32(OBJ_SNAP_ALIGN);
+    disk.max_attributes = snap_le32(MAX_ATTRIBUTES);
+    disk.num_objects = snap_le64(hdr.num_objects);
+    disk.num_names = snap_le64(hdr.num_names);
+    disk.column_stride = snap_le64(hdr.column_stride);
+    disk.file_size = snap_le64(hdr.file_size);
+    for (int s = 0; s < OBJ_SNAP_NSECTIONS; s++) {
+        disk.sections[s].offset = snap_le64(hdr.sections[s].offset);
+        disk.sections[s].size = snap_le64(hdr.sections[s].size);
+    }
+
+    /* Write to a temporary file, then rename it over the destination */
+    size_t tmp_len = strlen(path) + 5;
+    char* tmp = malloc(tmp_len);
+    if (!tmp) {
+        free(ids);
+        free(unique);
+        errno = ENOMEM;
+        return -1;
+    }
+    snprintf(tmp, tmp_len, "%s.tmp", path);
+
+    int ret = -1;
+    FILE* f = fopen(tmp, "wb");
+    if (f) {
+        if (fwrite(&disk, sizeof(disk), 1, f) == 1 &&
+            snap_write_body(f, &hdr, objs, count, ids, unique, n_unique) == 0 &&
+            fflush(f) == 0 && fsync(fileno(f)) == 0) {
+            ret = 0;
+        }
+        if (fclose(f) != 0) ret = -1;
+        if (ret == 0 && rename(tmp, path) != 0) ret = -1;
+        if (ret != 0) {
+            int saved = errno;
+            unlink(tmp);
+            errno = saved;
+        }
+    }
+
+    free(tmp);
+    free(ids);
+    free(unique);
+    return ret;
+}
+
+/* Check that a section lies inside the mapping */
+static int snap_section_ok(const ObjSnapHeader* hdr, int s, uint64_t file_size) {
+    uint64_t off = snap_le64(hdr->sections[s].offset);
+    uint64_t size = snap_le64(hdr->sections[s].size);
+    return off % OBJ_SNAP_ALIGN == 0 && off <= file_size && size <= file_size - off;
+}
+
+/* Map a snapshot file read-only */
+ObjSnapshot* obj_snapshot_open(const char* path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return NULL;
+    }
+    if ((uint64_t)st.st_size < sizeof(ObjSnapHeader)) {
+        close(fd);
+        errno = EINVAL;
+        return NULL;
+    }
+
+    void* base = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);  /* The mapping keeps the file alive */
+    if (base == MAP_FAILED) return NULL;
+
+    const ObjSnapHeader* hdr = base;
+    uint64_t size = (uint64_t)st.st_size;
+    uint64_t n = snap_le64(hdr->num_objects);
+    uint64_t stride = snap_le64(hdr->column_stride);
+    uint32_t n_attrs = snap_le32(hdr->max_attributes);
+
+    int ok = memcmp(hdr->magic, OBJ_SNAP_MAGIC, sizeof(hdr->magic)) == 0 &&
+             snap_le32(hdr->version) == OBJ_SNAP_VERSION &&
+             snap_le32(hdr->header_size) == sizeof(ObjSnapHeader) &&
+             snap_le64(hdr->file_size) == size &&
+             n <= UINT32_MAX && stride >= n * sizeof(uint32_t) &&
+             /* Bounds that keep the products below from wrapping around */
+             snap_le64(hdr->num_names) <= size / sizeof(uint64_t) &&
+             (n_attrs == 0 || stride <= size / n_attrs);
+    for (int s = 0; ok && s < OBJ_SNAP_NSECTIONS; s++) {
+        ok = snap_section_ok(hdr, s, size);
+    }
+    if (ok) {
+        uint64_t blob = snap_le64(hdr->sections[OBJ_SNAP_NAME_BLOB].size);
+        ok = snap_le64(hdr->sections[OBJ_SNAP_NAME_OFFSETS].size) == snap_le64(hdr->num_names) * sizeof(uint64_t) &&
+             snap_le64(hdr->sections[OBJ_SNAP_NAME_IDS].size) >= n * sizeof(uint32_t) &&
+             snap_le64(hdr->sections[OBJ_SNAP_NUM_ATTRS].size) >= n * sizeof(uint32_t) &&
+             snap_le64(hdr->sections[OBJ_SNAP_ATTRS].size) >= stride * n_attrs &&
+             /* A terminated blob makes every in-range name offset safe */
+             (blob == 0 ? snap_le64(hdr->num_names) == 0
+                        : ((const char*)base)[snap_le64(hdr->sections[OBJ_SNAP_NAME_BLOB].offset) + blob - 1] == '\0');
+    }
+
+    ObjSnapshot* snap = ok ? malloc(sizeof(ObjSnapshot)) : NULL;
+    if (!snap) {
+        munmap(base, (size_t)size);
+        errno = ok ? ENOMEM : EINVAL;
+        return NULL;
+    }
+
+    const unsigned char* b = base;
+    snap->base = base;
+    snap->size = (size_t)size;
+    snap->header = hdr;
+    snap->name_offsets = (const uint64_t*)(b + snap_le64(hdr->sections[OBJ_SNAP_NAME_OFFSETS].offset));
+    snap->names = (const char*)(b + snap_le64(hdr->sections[OBJ_SNAP_NAME_BLOB].offset));
+    snap->name_ids = (const uint32_t*)(b + snap_le64(hdr->sections[OBJ_SNAP_NAME_IDS].offset));
+    snap->num_attrs = (const int32_t*)(b + snap_le64(hdr->sections[OBJ_SNAP_NUM_ATTRS].offset));
+    snap->attrs = b + snap_le64(hdr->sections[OBJ_SNAP_ATTRS].offset);
+    return snap;
+}
+
+/* Unmap a snapshot */
+void obj_snapshot_close(ObjSnapshot* snap) {
+    if (!snap) return;
+    munmap(snap->base, snap->size);
+    free(snap);
+}
+
+/* Number of objects stored in the snapshot */
+size_t obj_snapshot_count(const ObjSnapshot* snap) {
+    return (size_t)snap_le64(snap->header->num_objects);
+}
+
+/* Name of the i-th object */
+const char* obj_snapshot_name(const ObjSnapshot* snap, size_t i) {
+    if (i >= obj_snapshot_count(snap)) return NULL;
+
+    uint32_t id = snap_le32(snap->name_ids[i]);
+    if (id >= snap_le64(snap->header->num_names)) return "";
+    uint64_t off = snap_le64(snap->name_offsets[id]);
+    if (off >= snap_le64(snap->header->sections[OBJ_SNAP_NAME_BLOB].size)) return "";
+    return snap->names + off;
+}
+
+/* Attribute of the i-th object */
+int obj_snapshot_get_attribute(const ObjSnapshot* snap, size_t i, int index) {
+    if (i >= obj_snapshot_count(snap) || index < 0 ||
+        index >= (int32_t)snap_le32((uint32_t)snap->num_attrs[i])) {
+        return -1;  /* Same convention as obj_get_attribute() */
+    }
+    const int32_t* col = obj_snapshot_column(snap, index);
+    return col ? (int32_t)snap_le32((uint32_t)col[i]) : -1;
+}
+
+/* Little-endian column of one attribute */
+const int32_t* obj_snapshot_column(const ObjSnapshot* snap, int index) {
+    if (index < 0 || (uint32_t)index >= snap_le32(snap->header->max_attributes)) return NULL;
+    return (const int32_t*)(snap->attrs + (uint64_t)index * snap_le64(snap->header->column_stride));
+}
+
+/* Fill a read-only view of the i-th object */
+int obj_snapshot_get(const ObjSnapshot* snap, size_t i, Object* view) {
+    if (i >= obj_snapshot_count(snap)) return -1;
+
+    view->name = (char*)obj_snapshot_name(snap, i);
+    view->num_attributes = (int32_t)snap_le32((uint32_t)snap->num_attrs[i]);
+    if (view->num_attributes < 0) view->num_attributes = 0;
+    if (view->num_attributes > MAX_ATTRIBUTES) view->num_attributes = MAX_ATTRIBUTES;
+    for (int a = 0; a < MAX_ATTRIBUTES; a++) {
+        const int32_t* col = obj_snapshot_column(snap, a);
+        view->attributes[a] = (a < view->num_attributes && col) ? (int32_t)snap_le32((uint32_t)col[i]) : 0;
+    }
+    return 0;
+}
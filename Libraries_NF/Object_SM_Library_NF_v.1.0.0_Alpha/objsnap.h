@@ -0,0 +1,105 @@
+/******************************************************************************/
+/*                                                                            */
+/*                 Object Snapshot Extension (objutil binary files)           */
+/*                                                                            */
+/* DESCRIPTION:                                                               */
+/* This extension stores an array of objects in a binary snapshot file that   */
+/* can be opened with mmap() and used immediately, without parsing.           */
+/* The file is versioned, little-endian and page-aligned: a header, an        */
+/* interned name table and one attribute column per attribute index.          */
+/* Several processes opening the same snapshot share the page cache.          */
+/*                                                                            */
+/* Copyright (c) 2026, Nico Fontani                                           */
+/* Creation Date: 19 Oct 2026                                                 */
+/*                                                                            */
+/* Original Author: Nico Fontani                                              */
+/* Last Modified: 19 Oct 2026                                                 */
+/*                                                                            */
+/* Supported by GCC and POSIX (mmap)                                          */
+/*                                                                            */
+/******************************************************************************/
+
+#ifndef OBJSNAP_H
+#define OBJSNAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "objutil.h"
+
+/* File identification */
+#define OBJ_SNAP_MAGIC   "NFOBJSNP"
+#define OBJ_SNAP_VERSION 1
+#define OBJ_SNAP_ALIGN   4096     /* Every section starts on this boundary */
+
+/* Sections of a snapshot file, in file order */
+enum {
+    OBJ_SNAP_NAME_OFFSETS,  /* uint64 per interned name: offset in the blob  */
+    OBJ_SNAP_NAME_BLOB,     /* NUL-terminated interned names                 */
+    OBJ_SNAP_NAME_IDS,      /* uint32 per object: index of its name          */
+    OBJ_SNAP_NUM_ATTRS,     /* int32 per object: num_attributes              */
+    OBJ_SNAP_ATTRS,         /* MAX_ATTRIBUTES columns of int32, one per index */
+    OBJ_SNAP_NSECTIONS
+};
+
+/* On-disk header (all fields little-endian) */
+typedef struct {
+    char     magic[8];        /* OBJ_SNAP_MAGIC, not NUL-terminated          */
+    uint32_t version;         /* OBJ_SNAP_VERSION                            */
+    uint32_t header_size;     /* sizeof(ObjSnapHeader) at write time         */
+    uint32_t align;           /* Section alignment used by the writer        */
+    uint32_t max_attributes;  /* Number of attribute columns                 */
+    uint64_t num_objects;
+    uint64_t num_names;       /* Distinct names after interning              */
+    uint64_t column_stride;   /* Distance in bytes between attribute columns */
+    uint64_t file_size;
+    struct {
+        uint64_t offset;
+        uint64_t size;
+    } sections[OBJ_SNAP_NSECTIONS];
+} ObjSnapHeader;
+
+/* An opened (mapped, read-only) snapshot */
+typedef struct {
+    void*                base;       /* Start of the mapping                  */
+    size_t               size;       /* Length of the mapping                 */
+    const ObjSnapHeader* header;
+    const uint64_t*      name_offsets;
+    const char*          names;
+    const uint32_t*      name_ids;
+    const int32_t*       num_attrs;
+    const unsigned char* attrs;      /* First attribute column                */
+} ObjSnapshot;
+
+/* Function prototypes */
+
+/* Write `count` objects to `path` (atomically, through a temporary file).
+   Returns 0 on success, -1 on failure (errno is set) */
+int obj_snapshot_write(const char* path, const Object* objs, size_t count);
+
+/* Map a snapshot file read-only and validate its header.
+   Returns NULL on failure (errno is set, EINVAL for a malformed file) */
+ObjSnapshot* obj_snapshot_open(const char* path);
+
+/* Unmap a snapshot; pointers obtained from it become invalid */
+void obj_snapshot_close(ObjSnapshot* snap);
+
+/* Number of objects stored in the snapshot */
+size_t obj_snapshot_count(const ObjSnapshot* snap);
+
+/* Name of the i-th object (points into the mapping) */
+const char* obj_snapshot_name(const ObjSnapshot* snap, size_t i);
+
+/* Attribute of the i-th object, -1 if the index is invalid (as obj_get_attribute) */
+int obj_snapshot_get_attribute(const ObjSnapshot* snap, size_t i, int index);
+
+/* Little-endian column of attribute `index` (obj_snapshot_count() entries),
+   or NULL if the index is invalid. Useful for scans over one attribute */
+const int32_t* obj_snapshot_column(const ObjSnapshot* snap, int index);
+
+/* Fill a read-only view of the i-th object. The name points into the mapping:
+   the view must not outlive the snapshot and must not be destroyed.
+   Returns 0 on success, -1 if i is out of range */
+int obj_snapshot_get(const ObjSnapshot* snap, size_t i, Object* view);
+
+#endif /* OBJSNAP_H */
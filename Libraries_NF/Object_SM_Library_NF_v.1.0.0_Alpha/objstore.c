@@ -0,0 +1,272 @@
+/******************************************************************************/
+/*                                                                            */
+/*                 Concurrent Object Store Extension (objutil)                */
+/*                                                                            */
+/* DESCRIPTION:                                                               */
+/* Seqlock reads, striped-lock writes and epoch-based reclamation for a       */
+/* table of objects shared between threads. See objstore.h.                   */
+/*                                                                            */
+/* Copyright (c) 2026, Nico Fontani                                           */
+/* Creation Date: 19 Oct 2026                                                 */
+/*                                                                            */
+/* Original Author: Nico Fontani                                              */
+/* Last Modified: 19 Oct 2026                                                 */
+/*                                                                            */
+/* Supported by GCC, C11 atomics and POSIX threads                            */
+/*                                                                            */
+/******************************************************************************/
+
+#include "objstore.h"
+
+/* Hint to the CPU that we are spinning */
+#if defined(__x86_64__) || defined(__i386__)
+#define STORE_RELAX() __builtin_ia32_pause()
+#else
+#define STORE_RELAX() ((void)0)
+#endif
+
+/* Stripe that protects an id */
+static pthread_mutex_t* store_stripe(ObjStore* store, size_t id) {
+    return &store->stripes[id % OBJ_STORE_STRIPES].lock;
+}
+
+/* Free an entry (its name was allocated by obj_init) */
+static void store_free_entry(ObjStoreEntry* entry) {
+    obj_destroy(&entry->obj);
+    free(entry);
+}
+
+/* Move the global epoch forward if every active thread has seen it */
+static void store_try_advance(ObjStore* store) {
+    uint64_t epoch = atomic_load(&store->global_epoch);
+    int n = atomic_load(&store->n_threads);
+
+    for (int t = 0; t < n; t++) {
+        uint64_t seen = atomic_load(&store->threads[t].epoch);
+        if (seen != 0 && seen != epoch) return;  /* Someone is still in an older epoch */
+    }
+    atomic_compare_exchange_strong(&store->global_epoch, &epoch, epoch + 1);
+}
+
+/* Free the retired entries of a thread that nobody can see any more:
+   an entry retired in epoch E is unreachable once the epoch is E + 2 */
+static void store_reclaim(ObjStore* store, int tid) {
+    ObjStoreThread* self = &store->threads[tid];
+    uint64_t epoch = atomic_load(&store->global_epoch);
+    ObjStoreEntry** link = &self->retired;
+
+    while (*link) {
+        ObjStoreEntry* entry = *link;
+        if (entry->retire_epoch + 2 <= epoch) {
+            *link = entry->retired_next;
+            store_free_entry(entry);
+            self->n_retired--;
+        } else {
+            link = &entry->retired_next;
+        }
+    }
+}
+
+/* Create a store */
+ObjStore* objstore_create(size_t capacity) {
+    ObjStore* store = aligned_alloc(OBJ_STORE_CACHE_LINE,
+                                    (sizeof(ObjStore) + OBJ_STORE_CACHE_LINE - 1) & ~(size_t)(OBJ_STORE_CACHE_LINE - 1));
+    if (!store) return NULL;
+
+    store->slots = calloc(capacity ? capacity : 1, sizeof(*store->slots));
+    if (!store->slots) {
+        free(store);
+        return NULL;
+    }
+    for (size_t i = 0; i < capacity; i++) atomic_init(&store->slots[i], NULL);
+    store->capacity = capacity;
+    atomic_init(&store->global_epoch, 1);
+    atomic_init(&store->n_threads, 0);
+    for (int s = 0; s < OBJ_STORE_STRIPES; s++) pthread_mutex_init(&store->stripes[s].lock, NULL);
+    for (int t = 0; t < OBJ_STORE_MAX_THREADS; t++) {
+        atomic_init(&store->threads[t].epoch, 0);
+        store->threads[t].retired = NULL;
+        store->threads[t].n_retired = 0;
+    }
+    return store;
+}
+
+/* Destroy the store */
+void objstore_destroy(ObjStore* store) {
+    if (!store) return;
+
+    for (size_t i = 0; i < store->capacity; i++) {
+        ObjStoreEntry* entry = atomic_load(&store->slots[i]);
+        if (entry) store_free_entry(entry);
+    }
+    for (int t = 0; t < OBJ_STORE_MAX_THREADS; t++) {
+        while (store->threads[t].retired) {
+            ObjStoreEntry* entry = store->threads[t].retired;
+            store->threads[t].retired = entry->retired_next;
+            store_free_entry(entry);
+        }
+    }
+    for (int s = 0; s < OBJ_STORE_STRIPES; s++) pthread_mutex_destroy(&store->stripes[s].lock);
+    free(store->slots);
+    free(store);
+}
+
+/* Register the calling thread */
+int objstore_thread_attach(ObjStore* store) {
+    int tid = atomic_fetch_add(&store->n_threads, 1);
+    if (tid >= OBJ_STORE_MAX_THREADS) {
+        atomic_fetch_sub(&store->n_threads, 1);
+        return -1;
+    }
+    return tid;
+}
+
+/* Enter a read section: publish the epoch we are reading in */
+void objstore_enter(ObjStore* store, int tid) {
+    atomic_store(&store->threads[tid].epoch, atomic_load(&store->global_epoch));
+    atomic_thread_fence(memory_order_seq_cst);
+}
+
+/* Leave a read section */
+void objstore_exit(ObjStore* store, int tid) {
+    atomic_store_explicit(&store->threads[tid].epoch, 0, memory_order_release);
+}
+
+/* Entry for an id */
+ObjStoreEntry* objstore_lookup(ObjStore* store, size_t id) {
+    if (id >= store->capacity) return NULL;
+    return atomic_load_explicit(&store->slots[id], memory_order_acquire);
+}
+
+/* Insert a new object */
+int objstore_insert(ObjStore* store, int tid, size_t id, const char* name) {
+    (void)tid;
+    if (id >= store->capacity) return -1;
+
+    ObjStoreEntry* entry = malloc(sizeof(ObjStoreEntry));
+    if (!entry) return -1;
+    obj_init(&entry->obj, name);
+    if (!entry->obj.name) {
+        free(entry);
+        return -1;
+    }
+    atomic_init(&entry->seq, 0);
+    entry->retire_epoch = 0;
+    entry->retired_next = NULL;
+
+    pthread_mutex_t* lock = store_stripe(store, id);
+    pthread_mutex_lock(lock);
+    ObjStoreEntry* expected = NULL;
+    int ok = atomic_compare_exchange_strong_explicit(&store->slots[id], &expected, entry,
+                                                     memory_order_release, memory_order_relaxed);
+    pthread_mutex_unlock(lock);
+
+    if (!ok) {
+        store_free_entry(entry);
+        return -1;
+    }
+    return 0;
+}
+
+/* Remove an object */
+int objstore_remove(ObjStore* store, int tid, size_t id) {
+    if (id >= store->capacity) return -1;
+
+    pthread_mutex_t* lock = store_stripe(store, id);
+    pthread_mutex_lock(lock);
+    ObjStoreEntry* entry = atomic_exchange_explicit(&store->slots[id], NULL, memory_order_acq_rel);
+    pthread_mutex_unlock(lock);
+    if (!entry) return -1;
+
+    /* Readers that already loaded the entry may still use it: retire it */
+    ObjStoreThread* self = &store->threads[tid];
+    entry->retire_epoch = atomic_load(&store->global_epoch);
+    entry->retired_next = self->retired;
+    self->retired = entry;
+    if (++self->n_retired >= OBJ_STORE_RETIRE_MAX) {
+        store_try_advance(store);
+        store_reclaim(store, tid);
+    }
+    return 0;
+}
+
+/* Set an attribute under the stripe lock, bumping the seqlock around it */
+int objstore_set_attribute(ObjStore* store, int tid, size_t id, int index, int value) {
+    (void)tid;
+    if (id >= store->capacity) return -1;
+
+    pthread_mutex_t* lock = store_stripe(store, id);
+    pthread_mutex_lock(lock);
+    ObjStoreEntry* entry = atomic_load_explicit(&store->slots[id], memory_order_relaxed);
+    if (!entry) {
+        pthread_mutex_unlock(lock);
+        return -1;
+    }
+
+    unsigned seq = atomic_load_explicit(&entry->seq, memory_order_relaxed);
+    atomic_store_explicit(&entry->seq, seq + 1, memory_order_relaxed);  /* Odd: write in progress */
+    atomic_thread_fence(memory_order_release);
+    if (index >= 0 && index < MAX_ATTRIBUTES) {
+        __atomic_store_n(&entry->obj.attributes[index], value, __ATOMIC_RELAXED);
+        if (index >= entry->obj.num_attributes) {
+            __atomic_store_n(&entry->obj.num_attributes, index + 1, __ATOMIC_RELAXED);
+        }
+    }
+    atomic_store_explicit(&entry->seq, seq + 2, memory_order_release);  /* Even: stable again */
+
+    pthread_mutex_unlock(lock);
+    return 0;
+}
+
+/* Get an attribute without blocking */
+int objstore_get_attribute(ObjStore* store, int tid, size_t id, int index) {
+    int value = -1;
+
+    objstore_enter(store, tid);
+    ObjStoreEntry* entry = objstore_lookup(store, id);
+    if (entry && index >= 0 && index < MAX_ATTRIBUTES) {
+        for (;;) {
+            unsigned seq = atomic_load_explicit(&entry->seq, memory_order_acquire);
+            if (seq & 1) {
+                STORE_RELAX();
+                continue;
+            }
+            int n = __atomic_load_n(&entry->obj.num_attributes, __ATOMIC_RELAXED);
+            value = (index < n) ? __atomic_load_n(&entry->obj.attributes[index], __ATOMIC_RELAXED) : -1;
+            atomic_thread_fence(memory_order_acquire);
+            if (atomic_load_explicit(&entry->seq, memory_order_relaxed) == seq) break;
+        }
+    }
+    objstore_exit(store, tid);
+    return value;
+}
+
+/* Consistent copy of an entry */
+void objstore_read_entry(ObjStoreEntry* entry, Object* out) {
+    for (;;) {
+        unsigned seq = atomic_load_explicit(&entry->seq, memory_order_acquire);
+        if (seq & 1) {
+            STORE_RELAX();
+            continue;
+        }
+        out->num_attributes = __atomic_load_n(&entry->obj.num_attributes, __ATOMIC_RELAXED);
+        for (int i = 0; i < MAX_ATTRIBUTES; i++) {
+            out->attributes[i] = __atomic_load_n(&entry->obj.attributes[i], __ATOMIC_RELAXED);
+        }
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&entry->seq, memory_order_relaxed) == seq) break;
+    }
+    out->name = entry->obj.name;  /* Never changes after insertion */
+}
+
+/* Consistent copy of an object */
+int objstore_read(ObjStore* store, int tid, size_t id, Object* out) {
+    objstore_enter(store, tid);
+    ObjStoreEntry* entry = objstore_lookup(store, id);
+    if (entry) objstore_read_entry(entry, out);
+    objstore_exit(store, tid);
+
+    if (!entry) return -1;
+    out->name = NULL;
+    return 0;
+}
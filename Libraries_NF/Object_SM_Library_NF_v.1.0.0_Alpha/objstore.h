@@ -0,0 +1,114 @@
+/******************************************************************************/
+/*                                                                            */
+/*                 Concurrent Object Store Extension (objutil)                */
+/*                                                                            */
+/* DESCRIPTION:                                                               */
+/* This extension keeps objects in a fixed-size table that many threads can   */
+/* use at the same time without a global mutex:                               */
+/*  - readers never block: every object carries a sequence counter (seqlock)  */
+/*    and a read is retried if a writer was updating the object meanwhile;    */
+/*  - writers take one of OBJ_STORE_STRIPES striped mutexes, chosen by id;    */
+/*  - removed objects are freed with epoch-based reclamation, only once no    */
+/*    reader can still be looking at them.                                    */
+/* Each thread must call objstore_thread_attach() once and pass the returned  */
+/* thread id to every other call.                                             */
+/*                                                                            */
+/* Copyright (c) 2026, Nico Fontani                                           */
+/* Creation Date: 19 Oct 2026                                                 */
+/*                                                                            */
+/* Original Author: Nico Fontani                                              */
+/* Last Modified: 19 Oct 2026                                                 */
+/*                                                                            */
+/* Supported by GCC, C11 atomics and POSIX threads                            */
+/*                                                                            */
+/******************************************************************************/
+
+#ifndef OBJSTORE_H
+#define OBJSTORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "objutil.h"
+
+#define OBJ_STORE_STRIPES     64    /* Writer locks, chosen by id % OBJ_STORE_STRIPES */
+#define OBJ_STORE_MAX_THREADS 128   /* Threads that can attach to one store */
+#define OBJ_STORE_RETIRE_MAX  64    /* Removed objects kept before reclaiming */
+#define OBJ_STORE_CACHE_LINE  64
+
+/* An object inside the store */
+typedef struct ObjStoreEntry {
+    atomic_uint           seq;           /* Odd while a writer is updating obj */
+    Object                obj;
+    uint64_t              retire_epoch;  /* Epoch in which it was removed */
+    struct ObjStoreEntry* retired_next;
+} ObjStoreEntry;
+
+/* Writer lock, alone on its cache line */
+typedef struct {
+    pthread_mutex_t lock;
+} __attribute__((aligned(OBJ_STORE_CACHE_LINE))) ObjStoreStripe;
+
+/* Per-thread reclamation state, alone on its cache line */
+typedef struct {
+    atomic_uint_fast64_t epoch;       /* Epoch seen on entry, 0 when outside */
+    ObjStoreEntry*       retired;     /* Removed, not yet freed (owner only) */
+    size_t               n_retired;
+} __attribute__((aligned(OBJ_STORE_CACHE_LINE))) ObjStoreThread;
+
+/* The store */
+typedef struct {
+    _Atomic(ObjStoreEntry*)* slots;      /* One slot per object id */
+    size_t                   capacity;
+    atomic_uint_fast64_t     global_epoch;
+    atomic_int               n_threads;
+    ObjStoreStripe           stripes[OBJ_STORE_STRIPES];
+    ObjStoreThread           threads[OBJ_STORE_MAX_THREADS];
+} ObjStore;
+
+/* Function prototypes */
+
+/* Create a store for object ids in [0, capacity). Returns NULL on failure */
+ObjStore* objstore_create(size_t capacity);
+
+/* Destroy the store and every object in it (no thread may be using it) */
+void objstore_destroy(ObjStore* store);
+
+/* Register the calling thread. Returns its thread id, -1 if the store is full */
+int objstore_thread_attach(ObjStore* store);
+
+/* Enter/leave a read section. Objects returned by objstore_lookup() stay
+   allocated until objstore_exit(). Sections must not be nested */
+void objstore_enter(ObjStore* store, int tid);
+void objstore_exit(ObjStore* store, int tid);
+
+/* Entry for an id, or NULL. Only valid inside objstore_enter()/exit() */
+ObjStoreEntry* objstore_lookup(ObjStore* store, size_t id);
+
+/* Insert a new object (as obj_init). Returns 0, or -1 if the id is invalid,
+   already in use or memory is exhausted */
+int objstore_insert(ObjStore* store, int tid, size_t id, const char* name);
+
+/* Remove an object; its memory is reclaimed once no reader can see it.
+   Returns 0, or -1 if there is no such object */
+int objstore_remove(ObjStore* store, int tid, size_t id);
+
+/* Set an attribute (as obj_set_attribute). Returns 0, or -1 if there is
+   no such object */
+int objstore_set_attribute(ObjStore* store, int tid, size_t id, int index, int value);
+
+/* Get an attribute without blocking (as obj_get_attribute: -1 if invalid) */
+int objstore_get_attribute(ObjStore* store, int tid, size_t id, int index);
+
+/* Consistent copy of an entry's attributes into `out` (seqlock read).
+   out->name points into the entry: it is only valid inside the read section */
+void objstore_read_entry(ObjStoreEntry* entry, Object* out);
+
+/* Consistent copy of an object, read without blocking. out->name is set to
+   NULL because the entry may be reclaimed after the call. Returns 0, or -1
+   if there is no such object */
+int objstore_read(ObjStore* store, int tid, size_t id, Object* out);
+
+#endif /* OBJSTORE_H */
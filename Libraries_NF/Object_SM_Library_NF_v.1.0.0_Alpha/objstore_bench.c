@@ -0,0 +1,154 @@
+/******************************************************************************/
+/*                                                                            */
+/*               Concurrent Object Store Read-Scaling Benchmark               */
+/*                                                                            */
+/* DESCRIPTION:                                                               */
+/* Compares a global mutex around objutil calls with objstore, using a        */
+/* 95/5 read/write mix, from 1 to 64 threads.                                 */
+/*                                                                            */
+/* Build: gcc -O2 -pthread objstore_bench.c objstore.c objutil.c              */
+/*            -o objstore_bench                                               */
+/* Usage: ./objstore_bench [N_OBJECTS] [MILLISECONDS_PER_RUN]                 */
+/*                                                                            */
+/* Copyright (c) 2026, Nico Fontani                                           */
+/* Creation Date: 19 Oct 2026                                                 */
+/*                                                                            */
+/* Original Author: Nico Fontani                                              */
+/* Last Modified: 19 Oct 2026                                                 */
+/*                                                                            */
+/* Supported by GCC, C11 atomics and POSIX threads                            */
+/*                                                                            */
+/******************************************************************************/
+
+#include <time.h>
+
+#include "objstore.h"
+
+#define READ_PERCENT 95
+#define MAX_BENCH_THREADS 64
+
+// Shared benchmark state
+static ObjStore* store;
+static Object* plain;                 // Objects protected by the global mutex
+static pthread_mutex_t global_lock = PTHREAD_MUTEX_INITIALIZER;
+static size_t n_objects;
+static atomic_int stop;
+
+// Per-thread result, on its own cache line
+typedef struct {
+    uint64_t ops;
+    int use_store;
+} __attribute__((aligned(64))) BenchThread;
+
+// Small per-thread PRNG (xorshift64*), so rand() does not serialize threads
+static uint64_t next_random(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 2685821657736338717ULL;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Worker: 95% reads, 5% writes on random objects until told to stop
+static void* bench_thread(void* arg) {
+    BenchThread* self = arg;
+    uint64_t rng = (uint64_t)(uintptr_t)self | 1;
+    uint64_t ops = 0;
+    long sink = 0;
+    int tid = self->use_store ? objstore_thread_attach(store) : -1;
+
+    while (!atomic_load_explicit(&stop, memory_order_relaxed)) {
+        uint64_t r = next_random(&rng);
+        size_t id = (size_t)(r >> 16) % n_objects;
+        int index = (int)(r % MAX_ATTRIBUTES);
+        int is_read = (int)((r >> 8) % 100) < READ_PERCENT;
+
+        if (self->use_store) {
+            if (is_read) sink += objstore_get_attribute(store, tid, id, index);
+            else objstore_set_attribute(store, tid, id, index, (int)r);
+        } else {
+            pthread_mutex_lock(&global_lock);
+            if (is_read) sink += obj_get_attribute(&plain[id], index);
+            else obj_set_attribute(&plain[id], index, (int)r);
+            pthread_mutex_unlock(&global_lock);
+        }
+        ops++;
+    }
+
+    self->ops = ops + (sink == 42);  // Keep the reads alive
+    return NULL;
+}
+
+// Run one configuration and return operations per second
+static double bench_run(int n_threads, int use_store, int millis) {
+    pthread_t threads[MAX_BENCH_THREADS];
+    BenchThread results[MAX_BENCH_THREADS];
+
+    if (use_store) {
+        // A fresh store for each run; this thread loads it as tid 0
+        int tid;
+        store = objstore_create(n_objects);
+        if (!store || (tid = objstore_thread_attach(store)) < 0) {
+            perror("objstore_create");
+            exit(EXIT_FAILURE);
+        }
+        for (size_t i = 0; i < n_objects; i++) objstore_insert(store, tid, i, "object");
+    }
+
+    atomic_store(&stop, 0);
+    double start = now_seconds();
+    for (int t = 0; t < n_threads; t++) {
+        results[t].ops = 0;
+        results[t].use_store = use_store;
+        pthread_create(&threads[t], NULL, bench_thread, &results[t]);
+    }
+
+    struct timespec pause = { millis / 1000, (millis % 1000) * 1000000L };
+    nanosleep(&pause, NULL);
+    atomic_store(&stop, 1);
+
+    uint64_t total = 0;
+    for (int t = 0; t < n_threads; t++) {
+        pthread_join(threads[t], NULL);
+        total += results[t].ops;
+    }
+    double elapsed = now_seconds() - start;
+
+    if (use_store) objstore_destroy(store);
+    return total / elapsed;
+}
+
+int main(int argc, char* argv[]) {
+    n_objects = (argc > 1) ? strtoul(argv[1], NULL, 10) : 100000;
+    int millis = (argc > 2) ? atoi(argv[2]) : 500;
+    if (n_objects == 0 || millis <= 0) {
+        printf("USAGE: %s [N_OBJECTS] [MILLISECONDS_PER_RUN]\n", argv[0]);
+        return -1;
+    }
+
+    plain = malloc(n_objects * sizeof(Object));
+    if (!plain) {
+        perror("malloc");
+        return -1;
+    }
+    for (size_t i = 0; i < n_objects; i++) obj_init(&plain[i], "object");
+
+    printf("%zu objects, %d%% reads, %d ms per run\n", n_objects, READ_PERCENT, millis);
+    printf("%8s %18s %18s %8s\n", "threads", "global mutex op/s", "objstore op/s", "speedup");
+    for (int n = 1; n <= MAX_BENCH_THREADS; n *= 2) {
+        double locked = bench_run(n, 0, millis);
+        double lockfree = bench_run(n, 1, millis);
+        printf("%8d %18.0f %18.0f %7.2fx\n", n, locked, lockfree, lockfree / locked);
+    }
+
+    for (size_t i = 0; i < n_objects; i++) obj_destroy(&plain[i]);
+    free(plain);
+    return 0;
+}
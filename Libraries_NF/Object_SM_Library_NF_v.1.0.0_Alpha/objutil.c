@@ -11,7 +11,7 @@
 /* Creation Date: 11 Nov 2024                                                 */
 /*                                                                            */
 /* Original Author: Nico Fontani                                              */
-/* Last Modified: 13 Nov 2024                                                 */
+/* Last Modified: 19 Oct 2026                                                 */
 /*                                                                            */
 /* Supported by C Programming                                                 */
 /*                                                                            */
@@ -28,6 +28,13 @@ void obj_init(Object* obj, const char* name) {
     }
 }
 
+/* Release the resources owned by an object (like a destructor) */
+void obj_destroy(Object* obj) {
+    free(obj->name);           /* Name was allocated by obj_init() */
+    obj->name = NULL;
+    obj->num_attributes = 0;
+}
+
 /* Set an attribute value for an object */
 void obj_set_attribute(Object* obj, int index, int value) {
     if (index >= 0 && index < MAX_ATTRIBUTES) {
@@ -48,9 +55,19 @@ int obj_get_attribute(Object* obj, int index) {
 
 /* Print the object's details */
 void obj_print(Object* obj) {
-    printf("Object: %s\n", obj->name);
-    printf("Attributes:\n");
-    for (int i = 0; i < obj->num_attributes; i++) {
-        printf("  Attribute %d: %d\n", i, obj->attributes[i]);
+    /* Build the whole report first, then hand it to stdio with one call
+       (objfmt.h offers a faster, fully buffered formatter for bulk dumps) */
+    const char* name = obj->name ? obj->name : "(null)";
+    size_t size = strlen(name) + 32 + (size_t)MAX_ATTRIBUTES * 40;
+    char local[1024];
+    char* text = (size <= sizeof(local)) ? local : malloc(size);
+    if (!text) return;
+
+    size_t len = (size_t)snprintf(text, size, "Object: %s\nAttributes:\n", name);
+    for (int i = 0; i < obj->num_attributes && i < MAX_ATTRIBUTES; i++) {
+        len += (size_t)snprintf(text + len, size - len, "  Attribute %d: %d\n", i, obj->attributes[i]);
     }
+    fwrite(text, 1, len, stdout);
+
+    if (text != local) free(text);
 }
@@ -11,7 +11,7 @@
 /* Creation Date: 10 Nov 2024                                                 */
 /*                                                                            */
 /* Original Author: Nico Fontani                                              */
-/* Last Modified: 13 Nov 2024                                                 */
+/* Last Modified: 19 Oct 2026                                                 */
 /*                                                                            */
 /* Supported by C Programming                                                 */
 /*                                                                            */
@@ -39,6 +39,11 @@ typedef struct {
 /* Initialize an object (like a constructor) */
 void obj_init(Object* obj, const char* name);
 
+/* Release the resources owned by an object (like a destructor).
+   Only for objects set up by obj_init(): pooled objects (objpool.h) go back
+   through obj_pool_release() */
+void obj_destroy(Object* obj);
+
 /* Set an attribute value for an object */
 void obj_set_attribute(Object* obj, int index, int value);
 
@@ -18,56 +18,39 @@
 /* and maintain clear version tracking.                                       */
 /*                                                                            */
 /* Original Author: Nico Fontani                                              */
-/* Last Modified: 13 Nov 2024                                                 */
+/* Last Modified: 19 Oct 2026                                                 */
 /*                                                                            */
 /******************************************************************************/
 
 #include <stdio.h>
 #include <unistd.h>
-#include "./mutex.h"
-#include "./shared.h"
-
-#define N_CICLES 100        // Number of cycles the dog will run
-#define MTX_KEY 4242        // Key for the mutex
-#define SHM_KEY 4243        // Key for the shared memory
-
-// Enum to represent the plate state (either CLEAN or POOP)
-typedef enum {
-    CLEAN, POOP
-} Plate;
+#include "./Garden.h"
 
 int main(int argc, char* argv[]) {
-
-    // Check if the number of plates is passed as an argument
-    if (argc != 2) {
-        printf("USAGE: %s #N_PLATES\n", argv[0]);
+    // Check the arguments: the number of plates, optionally the dog's index, and
+    // the garden's file descriptor and mutex ID when started by posix_spawn
+    if (argc != 2 && argc != 3 && argc != 5) {
+        printf("USAGE: %s #N_PLATES [#INDEX [#GARDEN_FD #MUTEX_ID]]\n", argv[0]);
         return -1;
     }
-    int n_plates = atoi(argv[1]);  // Number of plates
-    int mtx_id = mutex_find(MTX_KEY);  // Get the mutex using the key
-    int shm_id;
-    Plate* garden_path = shared_find(SHM_KEY, &shm_id);  // Get the shared memory area for the plates
-
-    srand(getpid());  // Seed the random number generator using the process ID
-     
-    int position = n_plates / 2;  // Start at the middle of the plates
-
-    printf("[%d] Dog is running around...\n", getpid());
-
-    // Run the simulation for N_CICLES cycles
-    for (int i = 0; i < N_CICLES; i++) {
-        position++;  // Move to the next position
-        if (position >= n_plates) position = 0;  // Wrap around if the position exceeds the number of plates
-        
-        mutex_lock(mtx_id);  // Lock the mutex to ensure exclusive access to the garden
-        if (rand() % 2) {  // Randomly decide if the dog will poop on the plate
-            *(garden_path + position) = POOP;        
-        }
-        mutex_unlock(mtx_id);  // Unlock the mutex after accessing the shared memory
-        
-        usleep(100);  // Simulate a short delay before the next action
+    int index = (argc >= 3) ? atoi(argv[2]) : 0;
+
+    // Find the mutex and shared memory segment (or map the ones handed over)
+    int mtx_id, shm_id;
+    GardenHeader* garden;
+    if (argc == 5) {
+        mtx_id = atoi(argv[4]);
+        garden = garden_attach_fd(atoi(argv[3]), mtx_id);
+    } else {
+        mtx_id = mutex_find(MTX_KEY);
+        garden = shared_find(SHM_KEY, &shm_id);
+    }
+    if (!garden || garden == (void*)-1) {
+        printf("[%d] No garden to run in\n", getpid());
+        return -1;
     }
 
-    printf("[%d] Dog is calm now...\n", getpid());  // Print when the dog has finished
+    // The loop itself lives in Garden.h, shared with the threaded garden
+    garden_dog(garden, mtx_id, index);
     return 0;
 }
@@ -8,6 +8,28 @@
 /* "poop" on the plates of the garden, and the owner maintains the garden.    */
 /* The program uses mutexes for synchronization and shared memory for        */
 /* storing the garden's state.                                                */
+/* With the optional #N_STRIPES argument the plates are split into stripes,   */
+/* each with its own lock, instead of sharing the single global mutex.        */
+/* With "lockfree" the plates change with a CAS and no mutex at all, with    */
+/* "bitset" each plate is one bit changed by atomic OR/AND. In every          */
+/* mode the final state is checked against the workers' operation logs.       */
+/* The option form (--plates, --dogs, --owners, --cycles) runs many dogs and  */
+/* owners, each pinned to a CPU and working on its own part of the garden,    */
+/* and prints the aggregate operations per second: the dogs run --cycles      */
+/* cycles, the owners until the dogs are done and their plates clean, and     */
+/* only the plates they clean count. With --queue the dogs                    */
+/* queue the plates they dirty and the owners pop them instead of sweeping.   */
+/* --bench drops the sleeps and seeds every dog's own generator, and prints   */
+/* per-worker latency histograms and checksums of the work and of the garden. */
+/* --launch starts the workers with fork+exec (default), posix_spawn handing  */
+/* over the garden's file descriptor, as threads of the garden, or from a     */
+/* pool forked once and reused by every one of --runs runs.                   */
+/* --monitor HZ streams snapshots of the plates while the workers run: the    */
+/* plates are copied chunk by chunk, and a worker about to change a chunk not */
+/* yet copied copies it first, so nobody waits for the whole garden.          */
+/* --numa interleaves the plates over the nodes or binds part k of them to    */
+/* node k (workers pinned there, each dog touching its plates first), and     */
+/* reports how many of the workers' pages are local.                          */
 /*                                                                            */
 /* Copyright (c) 2024, Nico Fontani                                           */
 /* Creation Date: 13 Nov 2024                                                 */
@@ -18,7 +40,7 @@
 /* and maintain clear version tracking.                                       */
 /*                                                                            */
 /* Original Author: Nico Fontani                                              */
-/* Last Modified: 13 Nov 2024                                                 */
+/* Last Modified: 19 Oct 2026                                                 */
 /*                                                                            */
 /******************************************************************************/
 
@@ -28,85 +50,593 @@
 #include <unistd.h>
 #include <wait.h>
 #include <errno.h>
+#include <time.h>
+#include <getopt.h>
+#include <limits.h>
+#include <pthread.h>
+#include <spawn.h>
 
-#include "./mutex.h"
-#include "./shared.h"
+#include "./Garden.h"
 
-#define MTX_KEY 4242       // Mutex key for synchronization
-#define SHM_KEY 4243       // Shared memory key for garden state
+#define GARDEN_MAX_LOG (1 << 22)  // Longest log kept per worker (32 MB)
+#define JOIN_TIMEOUT_MS 10000     // Longest wait for the workers to start
 
-// Enum to represent the state of the plates (either CLEAN or POOP)
+// How the dogs and the owners are started
 typedef enum {
-    CLEAN, POOP
-} Plate;
+    LAUNCH_EXEC, LAUNCH_SPAWN, LAUNCH_THREADS, LAUNCH_POOL
+} Launcher;
+
+const char* launch_names[] = { "exec", "spawn", "threads", "pool" };
+const char* numa_names[] = { "none", "off", "interleave", "bind" };
+
+extern char** environ;  // Passed on to the spawned workers
+
+// Settings of a run, from the command line
+typedef struct {
+    int n_plates;
+    GardenMode mode;
+    int n_stripes;
+    int n_dogs;
+    int n_owners;
+    long long cycles;
+    int pin;
+    int log;
+    int queue;
+    int bench;
+    unsigned long long seed;
+    Launcher launch;
+    int runs;
+    int monitor_hz;         // Snapshots per second, 0 = no monitor
+    GardenNuma numa;
+} Settings;
+
+// A dog or an owner run by a thread of the garden
+typedef struct {
+    pthread_t thread;
+    GardenHeader* garden;
+    int mtx_id;
+    int index;
+    int dog;
+} Worker;
+
+// Shared with the pre-forked workers
+typedef struct {
+    shm_notify_t job;       // Published at the start of every run
+    shm_notify_t done;      // Published by every worker at the end of a run
+    atomic_int finished;    // Runs completed, summed over the workers
+    int quit;
+} GardenPool;
+
+// Everything needed to start and wait for the workers
+typedef struct {
+    Settings* set;
+    int n_workers;
+    GardenHeader* garden;
+    int garden_fd;          // Anonymous segment, inherited by spawned workers
+    int mtx_id;
+    char dog_path[PATH_MAX];
+    char owner_path[PATH_MAX];
+    pid_t* pids;
+    Worker* threads;
+    GardenPool* pool;
+} Launch;
 
 // Function to handle errors
 void errore(int n, char* s);
 
+// Functions to read the command line
+void usage(char* name);
+int parse_args(int argc, char* argv[], Settings* set);
+
+// Functions to start and wait for the workers
+void worker_path(const char* name, char* path, size_t len);
+void* worker_thread(void* arg);
+void pool_worker(GardenPool* pool, GardenHeader* garden, int mtx_id, int worker);
+void start_workers(Launch* launch, int run);
+void wait_workers(Launch* launch, int run);
+
+// The monitor: streams snapshots of the garden while the workers run
+void monitor(GardenHeader* garden, int hz);
+
+// Function to check the final state against the workers' logs
+int check_garden(GardenHeader* garden);
+
+// Benchmark report: latency of every worker, throughput, checksums
+void report_bench(GardenHeader* garden, int n_workers, double elapsed, double ticks_per_ns);
+
 int main(int argc, char* argv[]) {
-    // Ensure the user provides the number of plates
-    if (argc != 2) {
-        printf("USAGE: %s #N_PLATES\n", argv[0]);
+    Settings set;
+    if (parse_args(argc, argv, &set) != 0) {
+        usage(argv[0]);
         return -1;
     }
-    int n_plates = atoi(argv[1]);  // Number of plates
-    char* cmd[] = { NULL, argv[1], NULL };  // Command for owner and dog processes
+    int n_plates = set.n_plates;  // Number of plates
+    int n_workers = set.n_dogs + set.n_owners;
+    // A dog changes a plate at most once a cycle; an owner, at most once per poop of every dog
+    long long max_changes = set.cycles * set.n_dogs;
+    int log_len = (set.log && max_changes <= GARDEN_MAX_LOG) ? (int)max_changes : 0;
+    int queue_len = set.queue ? garden_queue_len(n_plates) : 0;
+    int failed = 0;
+
+    // The workers sit next to the garden program, wherever it is started from
+    Launch launch = { .set = &set, .n_workers = n_workers, .garden_fd = -1 };
+    worker_path("dog", launch.dog_path, sizeof(launch.dog_path));
+    worker_path("owner", launch.owner_path, sizeof(launch.owner_path));
 
     // Create a mutex for synchronization
-    int mtx_id = mutex_create(MTX_KEY, 1);
-    if (mtx_id == -1) errore(-2, "mutex_create()");
-    mutex_lock(mtx_id);  // Lock the mutex to control access to shared resources
+    launch.mtx_id = mutex_create(MTX_KEY, 1);
+    if (launch.mtx_id == -1) errore(-2, "mutex_create()");
 
-    // Create shared memory for the garden state (plates)
-    int shm_id;
-    Plate* garden_path = shared_create(SHM_KEY, sizeof(Plate) * n_plates, &shm_id);
-    if (!garden_path) errore(-3, "shared_create()");
+    // Create shared memory for the garden state (header, stripe locks, plates, queue, logs):
+    // found by key by the exec'd workers, an anonymous segment for the other launchers
+    int shm_id = -1;
+    size_t size = garden_size(n_plates, set.mode, set.n_stripes, n_workers, log_len, queue_len, set.monitor_hz > 0);
+    GardenHeader* garden;
+    if (set.launch == LAUNCH_EXEC) garden = shared_create(SHM_KEY, size, &shm_id);
+    else garden = shared_create_anon(size, 0, &launch.garden_fd);
+    if (!garden || garden == (void*)-1) errore(-3, "shared_create()");
+    launch.garden = garden;
 
-    // Initialize all plates as CLEAN
-    for (int i = 0; i < n_plates; i++) {
-        *(garden_path + i) = CLEAN;
+    // Pre-forked pool: the workers are started once and reused by every run
+    if (set.launch == LAUNCH_POOL) {
+        int pool_fd;
+        launch.pool = shared_create_anon(sizeof(GardenPool), 0, &pool_fd);
+        if (!launch.pool) errore(-3, "shared_create_anon()");
+        close(pool_fd);
+        fflush(stdout);  // The children must not inherit buffered output
+        for (int w = 0; w < n_workers; w++) {
+            if (!fork()) pool_worker(launch.pool, garden, launch.mtx_id, w);
+        }
     }
 
-    // Simulate placing the owner in the garden
-    printf("Build the garden...\n");
-    printf("Place the Owner...\n");
-    cmd[0] = "./owner";  // Set the command to execute the owner process
-    if (!fork()) {  // Create the owner process
-        execvp(*cmd, cmd);
-        errore(-2, "execvp()");  // If execvp fails, report error
-    }
+    for (int run = 0; run < set.runs; run++) {
+        // Initialize all plates as CLEAN (on NUMA machines, placed first)
+        garden->numa = set.numa;
+        garden_init(garden, n_plates, set.mode, set.n_stripes, n_workers, log_len, queue_len, set.monitor_hz > 0);
+        garden->n_dogs = set.n_dogs;
+        garden->n_owners = set.n_owners;
+        garden->cycles = set.cycles;
+        garden->pin = set.pin;
+        garden->bench = set.bench;
+        garden->seed = set.seed;
+        if (garden_place(garden) != 0) printf("NUMA placement failed: %s\n", strerror(errno));
+        double ticks_per_ns = set.bench ? mutex_stats_calibrate() : 1;
 
-    // Simulate placing the dog in the garden
-    printf("Place the dog...\n");
-    cmd[0] = "./dog";  // Set the command to execute the dog process
-    if (!fork()) {  // Create the dog process
-        execvp(*cmd, cmd);
-        errore(-2, "execvp()");  // If execvp fails, report error
-    }
+        // Simulate placing the owners in the garden
+        if (set.runs > 1) printf("\n=== Run %d of %d ===\n", run + 1, set.runs);
+        printf("Build the garden...\n");
+        if (set.mode == GARDEN_STRIPED) printf("%d stripes of %d plates...\n", set.n_stripes, garden->stripe_len);
+        if (set.mode == GARDEN_LOCKFREE) printf("No locks on the plates...\n");
+        if (set.mode == GARDEN_BITSET) printf("One bit per plate, %zu bytes...\n", garden_plates_size(set.mode, n_plates));
+        if (queue_len) printf("Dirty plates queued for the owners, %d slots...\n", queue_len);
+        if (set.bench) printf("Benchmark mode: no sleeps, seed %llu...\n", set.seed);
+        if (set.numa) printf("NUMA placement %s on %d node%s...\n", numa_names[set.numa], garden->n_nodes, garden->n_nodes == 1 ? "" : "s");
+        if (!log_len) printf("No operation logs, %lld cycles per dog...\n", set.cycles);
+        if (set.n_owners == 1) printf("Place the Owner...\n");
+        else printf("Place %d owners...\n", set.n_owners);
+        if (set.n_dogs == 1) printf("Place the dog...\n");
+        else printf("Place %d dogs...\n", set.n_dogs);
+        fflush(stdout);  // The children must not inherit buffered output
 
-    // Release the dog to start interacting with the garden
-    printf("Release the dog...\n\n");
-    mutex_unlock(mtx_id);  // Unlock the mutex to allow processes to proceed
+        // Start the workers and wait until all of them are in the garden
+        long long launch_ns = garden_now_ns();
+        start_workers(&launch, run);
+        int joined = garden_wait_joined(garden, n_workers, JOIN_TIMEOUT_MS);
+        long long ready_ns = garden_now_ns();
+        if (joined < n_workers) printf("Only %d of %d workers joined the garden\n", joined, n_workers);
 
-    // Wait for the owner and dog processes to finish
-    wait(NULL);
-    wait(NULL);
+        // Release the dogs to start interacting with the garden
+        printf("Release the dog%s...\n\n", set.n_dogs == 1 ? "" : "s");
+        fflush(stdout);
+        double start = mutex_stats_seconds();
+        garden_release(garden);
 
-    // Print the final state of the garden
-    printf("\n[");
-    for (int i = 0; i < n_plates; i++) {
-        printf("%c ", (*(garden_path + i) == CLEAN) ? '.' : 'P');  // Print clean or pooped plates
+        // Watch the garden while they work
+        pid_t monitor_pid = 0;
+        if (set.monitor_hz && !(monitor_pid = fork())) monitor(garden, set.monitor_hz);
+
+        // Wait for the owners and the dogs to finish
+        wait_workers(&launch, run);
+        double elapsed = mutex_stats_seconds() - start;
+        if (monitor_pid > 0) {
+            __atomic_store_n(&garden->finished, 1, __ATOMIC_RELEASE);
+            waitpid(monitor_pid, NULL, 0);
+        }
+
+        // Print the final state of the garden (only the summary if it is huge)
+        if (n_plates <= GARDEN_PRINT_MAX) {
+            printf("\n[");
+            for (int i = 0; i < n_plates; i++) {
+                printf("%c ", (garden_plate(garden, i) == CLEAN) ? '.' : 'P');  // Print clean or pooped plates
+            }
+            printf("]\n");
+        }
+        printf("%lld dirty plates of %d\n", garden_count_dirty(garden), n_plates);
+
+        // Aggregate throughput: a dog's cycle, or a plate an owner cleaned, is one operation
+        long long ops = 0, cleaned = 0, last_first_ns = ready_ns;
+        long local_pages = 0, remote_pages = 0;
+        if (joined > n_workers) joined = n_workers;
+        for (int w = 0; w < joined; w++) {
+            GardenLog* log = garden_log(garden, w);
+            ops += log->ops;
+            if (!log->dog) cleaned += log->ops;
+            if (log->first_ns > last_first_ns) last_first_ns = log->first_ns;
+            local_pages += log->local_pages;
+            remote_pages += log->remote_pages;
+        }
+        printf("%d dogs, %d owners: %lld dog cycles and %lld plates cleaned in %.3f s, %.0f ops/s\n",
+               set.n_dogs, set.n_owners, ops - cleaned, cleaned, elapsed, ops / elapsed);
+        printf("Startup (%s): all joined after %.3f ms, all working after %.3f ms\n", launch_names[set.launch],
+               (ready_ns - launch_ns) / 1e6, (last_first_ns - launch_ns) / 1e6);
+
+        if (set.numa && local_pages + remote_pages) {
+            printf("NUMA (%s): %.1f%% of the workers' pages local (%ld local, %ld remote)\n", numa_names[set.numa],
+                   100.0 * local_pages / (local_pages + remote_pages), local_pages, remote_pages);
+        }
+
+        if (set.bench) report_bench(garden, n_workers, elapsed, ticks_per_ns);
+
+        // Check that the final state matches what the workers did
+        if (!check_garden(garden)) failed = 1;
     }
-    printf("]\n");
 
     // Clean up the resources
     printf("Clean everything...\n");
-    mutex_remove(mtx_id);  // Remove the mutex
-    shared_remove(shm_id);  // Remove the shared memory
+    if (launch.pool) {
+        launch.pool->quit = 1;
+        shm_notify_publish(&launch.pool->job);
+        while (wait(NULL) > 0)
+            ;
+    }
+    mutex_remove(launch.mtx_id);  // Remove the mutex
+    if (set.launch == LAUNCH_EXEC) shared_remove(shm_id);  // Remove the shared memory
+    else shared_unmap(garden, size);
+
+    return failed ? 1 : 0;
+}
+
+// Takes `hz` snapshots per second until the workers are done. A snapshot never
+// stops them; it is a consistent view of the plates at the moment it started.
+void monitor(GardenHeader* garden, int hz) {
+    long long period_ns = 1000000000LL / hz;
+    long long next = garden_now_ns();
+    int taken = 0;
+    double total_ms = 0, max_ms = 0;
+
+    while (!__atomic_load_n(&garden->finished, __ATOMIC_ACQUIRE)) {
+        long long t0 = garden_now_ns();
+        const void* snapshot = garden_snapshot(garden);
+        double ms = (garden_now_ns() - t0) / 1e6;
+        printf("[monitor] snapshot %u: %lld dirty plates (taken in %.3f ms)\n",
+               atomic_load(&garden->snap_published), garden_snap_count_dirty(garden, snapshot), ms);
+        fflush(stdout);
+        taken++;
+        total_ms += ms;
+        if (ms > max_ms) max_ms = ms;
+
+        // Next snapshot at the next tick (no catching up if one took too long)
+        next += period_ns;
+        long long left = next - garden_now_ns();
+        if (left < 0) next -= left;
+        else {
+            struct timespec ts = { left / 1000000000LL, left % 1000000000LL };
+            nanosleep(&ts, NULL);
+        }
+    }
+    printf("[monitor] %d snapshots, %.3f ms on average, %.3f ms at most, %llu chunks copied by the workers\n",
+           taken, taken ? total_ms / taken : 0, max_ms, (unsigned long long)atomic_load(&garden->snap_cows));
+    exit(0);
+}
+
+// Path of a worker program, in the same directory as this one
+void worker_path(const char* name, char* path, size_t len) {
+    char self[PATH_MAX];
+    ssize_t n = readlink("/proc/self/exe", self, sizeof(self) - 1);
+    char* slash = NULL;
+    if (n > 0) {
+        self[n] = '\0';
+        slash = strrchr(self, '/');
+    }
+    if (slash) {
+        *slash = '\0';
+        snprintf(path, len, "%s/%s", self, name);
+    } else {
+        snprintf(path, len, "./%s", name);
+    }
+}
+
+// Thread mode: a dog or an owner runs in a thread of the garden
+void* worker_thread(void* arg) {
+    Worker* worker = arg;
+    if (worker->dog) garden_dog(worker->garden, worker->mtx_id, worker->index);
+    else garden_owner(worker->garden, worker->mtx_id, worker->index);
+    return NULL;
+}
+
+// A worker of the pool: waits for a run, plays its part, tells the garden
+void pool_worker(GardenPool* pool, GardenHeader* garden, int mtx_id, int worker) {
+    uint32_t seen = 0;
+    for (;;) {
+        uint32_t job = shm_wait_change(&pool->job, seen, -1);
+        if (job == seen) continue;
+        seen = job;
+        if (pool->quit) break;
+
+        if (worker < garden->n_dogs) garden_dog(garden, mtx_id, worker);
+        else garden_owner(garden, mtx_id, worker - garden->n_dogs);
+        fflush(stdout);
+        atomic_fetch_add(&pool->finished, 1);
+        shm_notify_publish(&pool->done);
+    }
+    exit(0);
+}
+
+// Start the owners and the dogs of a run
+void start_workers(Launch* launch, int run) {
+    Settings* set = launch->set;
+    char plates_arg[16], index_arg[16], fd_arg[16], mtx_arg[16];
+    snprintf(plates_arg, sizeof(plates_arg), "%d", set->n_plates);
+    snprintf(fd_arg, sizeof(fd_arg), "%d", launch->garden_fd);
+    snprintf(mtx_arg, sizeof(mtx_arg), "%d", launch->mtx_id);
+
+    // Command for owner and dog processes: WORKER N_PLATES INDEX [GARDEN_FD MUTEX_ID]
+    char* cmd[] = { NULL, plates_arg, index_arg, fd_arg, mtx_arg, NULL };
+    if (set->launch == LAUNCH_EXEC) cmd[3] = NULL;
+
+    if (set->launch == LAUNCH_POOL) {
+        shm_notify_publish(&launch->pool->job);
+        return;
+    }
+    if (run == 0) {
+        launch->pids = calloc(launch->n_workers, sizeof(pid_t));
+        launch->threads = calloc(launch->n_workers, sizeof(Worker));
+        if (!launch->pids || !launch->threads) errore(-4, "calloc()");
+    }
+
+    for (int w = 0; w < launch->n_workers; w++) {
+        int dog = w >= set->n_owners;  // Owners first, as they have always been placed
+        int index = dog ? w - set->n_owners : w;
+        snprintf(index_arg, sizeof(index_arg), "%d", index);
+        cmd[0] = dog ? launch->dog_path : launch->owner_path;
+
+        if (set->launch == LAUNCH_THREADS) {
+            Worker* worker = &launch->threads[w];
+            worker->garden = launch->garden;
+            worker->mtx_id = launch->mtx_id;
+            worker->index = index;
+            worker->dog = dog;
+            if (pthread_create(&worker->thread, NULL, worker_thread, worker) != 0) errore(-2, "pthread_create()");
+        } else if (set->launch == LAUNCH_SPAWN) {
+            // No copy of the garden's address space, and the segment is already open
+            if (posix_spawn(&launch->pids[w], cmd[0], NULL, NULL, cmd, environ) != 0) errore(-2, "posix_spawn()");
+        } else {
+            launch->pids[w] = fork();
+            if (!launch->pids[w]) {  // Create an owner or a dog process
+                execv(cmd[0], cmd);
+                errore(-2, "execv()");  // If execv fails, report error
+            }
+        }
+    }
+}
+
+// Wait for the owners and the dogs of a run to finish
+void wait_workers(Launch* launch, int run) {
+    if (launch->set->launch == LAUNCH_POOL) {
+        int target = launch->n_workers * (run + 1);
+        uint32_t seen = shm_notify_read(&launch->pool->done);
+        while (atomic_load(&launch->pool->finished) < target) seen = shm_wait_change(&launch->pool->done, seen, 100);
+        return;
+    }
+    for (int w = 0; w < launch->n_workers; w++) {
+        if (launch->set->launch == LAUNCH_THREADS) pthread_join(launch->threads[w].thread, NULL);
+        else waitpid(launch->pids[w], NULL, 0);
+    }
+}
+
+void usage(char* name) {
+    printf("USAGE: %s #N_PLATES [#N_STRIPES | lockfree | bitset]\n", name);
+    printf("       %s --plates P [--dogs N] [--owners M] [--cycles C]\n"
+           "              [--stripes K | --lockfree | --bitset] [--queue] [--no-pin] [--no-log]\n"
+           "              [--bench [--seed S]] [--launch exec|spawn|threads|pool] [--runs R]\n"
+           "              [--monitor HZ] [--numa off|interleave|bind]\n", name);
+}
+
+// Reads either the classic positional form (one dog, one owner, not pinned)
+// or the options (any number of workers, pinned unless --no-pin).
+// RETURNS: 0 if the settings are valid
+int parse_args(int argc, char* argv[], Settings* set) {
+    set->n_plates = 0;
+    set->mode = GARDEN_GLOBAL;
+    set->n_stripes = 0;
+    set->n_dogs = 1;
+    set->n_owners = 1;
+    set->cycles = N_CICLES;
+    set->pin = 0;
+    set->log = 1;
+    set->queue = 0;
+    set->bench = 0;
+    set->seed = GARDEN_SEED;
+    set->launch = LAUNCH_EXEC;
+    set->runs = 1;
+    set->monitor_hz = 0;
+    set->numa = GARDEN_NUMA_NONE;
+
+    if (argc >= 2 && argv[1][0] != '-') {
+        if (argc != 2 && argc != 3) return -1;
+        set->n_plates = atoi(argv[1]);
+        if (argc == 3 && !strcmp(argv[2], "lockfree")) {
+            set->mode = GARDEN_LOCKFREE;  // CAS on the plates, no mutex at all
+        } else if (argc == 3 && !strcmp(argv[2], "bitset")) {
+            set->mode = GARDEN_BITSET;  // One bit per plate, atomic OR / AND
+        } else if (argc == 3) {
+            set->mode = GARDEN_STRIPED;
+            set->n_stripes = atoi(argv[2]);
+        }
+    } else {
+        static struct option options[] = {
+            { "plates",   required_argument, NULL, 'p' },
+            { "dogs",     required_argument, NULL, 'd' },
+            { "owners",   required_argument, NULL, 'o' },
+            { "cycles",   required_argument, NULL, 'c' },
+            { "stripes",  required_argument, NULL, 's' },
+            { "lockfree", no_argument,       NULL, 'l' },
+            { "bitset",   no_argument,       NULL, 'b' },
+            { "no-pin",   no_argument,       NULL, 'P' },
+            { "no-log",   no_argument,       NULL, 'L' },
+            { "queue",    no_argument,       NULL, 'q' },
+            { "bench",    no_argument,       NULL, 'B' },
+            { "seed",     required_argument, NULL, 'S' },
+            { "launch",   required_argument, NULL, 'm' },
+            { "runs",     required_argument, NULL, 'r' },
+            { "monitor",  required_argument, NULL, 'M' },
+            { "numa",     required_argument, NULL, 'N' },
+            { NULL, 0, NULL, 0 }
+        };
+        int opt;
+        set->pin = 1;
+        while ((opt = getopt_long(argc, argv, "p:d:o:c:s:lbq", options, NULL)) != -1) {
+            switch (opt) {
+            case 'p': set->n_plates = atoi(optarg); break;
+            case 'd': set->n_dogs = atoi(optarg); break;
+            case 'o': set->n_owners = atoi(optarg); break;
+            case 'c': set->cycles = atoll(optarg); break;
+            case 's': set->mode = GARDEN_STRIPED; set->n_stripes = atoi(optarg); break;
+            case 'l': set->mode = GARDEN_LOCKFREE; break;
+            case 'b': set->mode = GARDEN_BITSET; break;
+            case 'P': set->pin = 0; break;
+            case 'L': set->log = 0; break;
+            case 'q': set->queue = 1; break;
+            case 'B': set->bench = 1; break;
+            case 'S': set->seed = strtoull(optarg, NULL, 0); break;
+            case 'm':
+                for (set->launch = LAUNCH_EXEC; set->launch <= LAUNCH_POOL; set->launch++) {
+                    if (!strcmp(optarg, launch_names[set->launch])) break;
+                }
+                if (set->launch > LAUNCH_POOL) return -1;
+                break;
+            case 'r': set->runs = atoi(optarg); break;
+            case 'M': set->monitor_hz = atoi(optarg); break;
+            case 'N':
+                for (set->numa = GARDEN_NUMA_OFF; set->numa <= GARDEN_NUMA_BIND; set->numa++) {
+                    if (!strcmp(optarg, numa_names[set->numa])) break;
+                }
+                if (set->numa > GARDEN_NUMA_BIND) return -1;
+                break;
+            default: return -1;
+            }
+        }
+        if (optind != argc) return -1;
+    }
 
+    if (set->n_plates <= 0 || set->n_dogs <= 0 || set->n_owners <= 0 || set->cycles <= 0 || set->runs <= 0) return -1;
+    if (set->monitor_hz < 0) return -1;
+    if (set->mode == GARDEN_STRIPED && (set->n_stripes <= 0 || set->n_stripes > GARDEN_MAX_STRIPES)) return -1;
+    if (set->n_stripes > set->n_plates) set->n_stripes = set->n_plates;  // No empty stripes
     return 0;
 }
 
+// Consistency checker: replays the workers' logs.
+// On each plate the transitions alternate CLEAN -> POOP -> CLEAN ..., so
+// poops - cleans must be 0 (plate CLEAN) or 1 (plate POOP), and the logs
+// must add up to the global counters, and the queue (--queue) must hold
+// exactly the dirty plates. Without logs (--no-log, or too many
+// cycles) only the counters are checked against the dirty plates.
+int check_garden(GardenHeader* garden) {
+    int n_plates = garden->n_plates;
+    int* balance = calloc(n_plates, sizeof(int));
+    unsigned long long poops = 0, cleans = 0;
+    int errors = 0;
+    if (!balance) errore(-4, "calloc()");
+
+    // Every dirty plate is still waiting in the queue, and nothing else is
+    if (garden->queue_len && garden_queue_count(garden) != garden_count_dirty(garden)) {
+        printf("Check: %lld plates queued but %lld dirty plates\n", garden_queue_count(garden), garden_count_dirty(garden));
+        errors++;
+    }
+
+    if (garden->log_len == 0) {
+        poops = atomic_load(&garden->poops);
+        cleans = atomic_load(&garden->cleans);
+        if ((long long)(poops - cleans) != garden_count_dirty(garden)) {
+            printf("Check: %llu poops - %llu cleans but %lld dirty plates\n", poops, cleans, garden_count_dirty(garden));
+            errors++;
+        }
+        free(balance);
+        printf("Consistency check: %s (%llu poops, %llu cleans, counters only)\n", errors ? "FAILED" : "OK", poops, cleans);
+        return errors == 0;
+    }
+
+    int joined = atomic_load(&garden->joined);
+    if (joined > garden->max_workers) joined = garden->max_workers;
+    for (int w = 0; w < joined; w++) {
+        GardenLog* log = garden_log(garden, w);
+        if (log->count > garden->log_len) {
+            printf("Check: log of [%d] overflowed (%d entries)\n", log->pid, log->count);
+            errors++;
+            continue;
+        }
+        for (int k = 0; k < log->count; k++) {
+            GardenOp* op = &garden_log_ops(log)[k];
+            if (op->to == POOP) {
+                balance[op->position]++;
+                poops++;
+            } else {
+                balance[op->position]--;
+                cleans++;
+            }
+        }
+    }
+
+    for (int i = 0; i < n_plates; i++) {
+        Plate plate = garden_plate(garden, i);
+        int expected = (plate == POOP) ? 1 : 0;
+        if (balance[i] != expected) {
+            printf("Check: plate %d is %s but the logs give %d poops more than cleans\n",
+                   i, plate == POOP ? "POOP" : "CLEAN", balance[i]);
+            errors++;
+        }
+    }
+    if (poops != atomic_load(&garden->poops) || cleans != atomic_load(&garden->cleans)) {
+        printf("Check: logs have %llu poops / %llu cleans, counters %llu / %llu\n", poops, cleans,
+               (unsigned long long)atomic_load(&garden->poops), (unsigned long long)atomic_load(&garden->cleans));
+        errors++;
+    }
+    free(balance);
+
+    printf("Consistency check: %s (%llu poops, %llu cleans)\n", errors ? "FAILED" : "OK", poops, cleans);
+    return errors == 0;
+}
+
+// Every worker: poops / cleans timed, with their median, 99th percentile and
+// log2 histogram. The workload checksum only depends on the seed and the
+// number of dogs and plates: equal checksums mean the same work was done.
+void report_bench(GardenHeader* garden, int n_workers, double elapsed, double ticks_per_ns) {
+    unsigned long long workload = 0;
+    int joined = atomic_load(&garden->joined);
+    if (joined > n_workers) joined = n_workers;
+
+    printf("\n%-10s %8s %12s %12s %10s %10s\n", "worker", "pid", "ops", "changes", "p50 (ns)", "p99 (ns)");
+    for (int w = 0; w < joined; w++) {
+        GardenLog* log = garden_log(garden, w);
+        char who[16];
+        snprintf(who, sizeof(who), "%s %d", log->dog ? "dog" : "owner", log->index);
+        printf("%-10s %8d %12lld %12d %10.0f %10.0f\n", who, log->pid, log->ops, log->count,
+               mutex_stats_percentile(log->hist, 0.5, ticks_per_ns), mutex_stats_percentile(log->hist, 0.99, ticks_per_ns));
+        printf("%-10s", "");
+        for (int b = 0; b < MUTEX_STATS_BUCKETS; b++) {
+            if (log->hist[b]) printf(" <%.0f:%llu", (2ull << b) / ticks_per_ns, (unsigned long long)log->hist[b]);
+        }
+        printf("\n");
+        if (log->dog) workload ^= log->workload;
+    }
+
+    unsigned long long changes = atomic_load(&garden->poops) + atomic_load(&garden->cleans);
+    printf("Throughput: %.0f plate changes/s\n", changes / elapsed);
+    printf("Workload checksum: %016llx\n", workload);
+    printf("Final state checksum: %016llx\n", garden_checksum(garden));
+}
+
 // Error handling function
 void errore(int n, char* s) {
     // Print the error message and exit
@@ -0,0 +1,996 @@
+/******************************************************************************/
+/*                                                                            */
+/*                         GARDEN SHARED DEFINITIONS                          */
+/*                                                                            */
+/* DESCRIPTION:                                                               */
+/* Definitions shared by the garden, the owner and the dog: the plate states, */
+/* the IPC keys and the layout of the shared memory segment.                  */
+/* The segment starts with a GardenHeader, followed by the stripe locks, the  */
+/* plates, the dirty-plate queue (--queue) and the snapshot area (--monitor:  */
+/* the epoch and writer count of every chunk, then two copies of the plates): */
+/*                                                                            */
+/*   [ GardenHeader | GardenStripe x n_stripes | Plate x n_plates |           */
+/*     GardenQueue + GardenSlot x queue_len |                                 */
+/*     atomic_uint x chunks x 2 | Plate x n_plates x 2 |                      */
+/*     GardenLog x max_workers ]                                              */
+/*                                                                            */
+/* Plates are changed in one of four modes:                                   */
+/*  - GARDEN_GLOBAL: every access takes the global MTX_KEY mutex.             */
+/*  - GARDEN_STRIPED: the plates are split into K contiguous stripes and a    */
+/*    worker only locks the stripe holding the plate it touches.              */
+/*  - GARDEN_LOCKFREE: no lock at all, a plate changes with one CAS.          */
+/*  - GARDEN_BITSET: one bit per plate (64 plates per word, 32 times less     */
+/*    memory), changed with atomic OR / AND. The owner finds dirty plates     */
+/*    with tzcnt, skipping clean words 4 at a time with AVX2 when available.  */
+/* In every mode each worker logs the transitions it made, so the garden can  */
+/* check the final state against them.                                        */
+/* There can be many dogs and owners: each works on its own contiguous        */
+/* partition of the plates (owners in bitset mode steal from the others when  */
+/* theirs is clean) and may be pinned to a CPU.                               */
+/*                                                                            */
+/* Copyright (c) 2026, Nico Fontani                                           */
+/* Creation Date: 19 Oct 2026                                                 */
+/*                                                                            */
+/* This code was developed by Nico Fontani. Its use and modification are      */
+/* permitted, provided that any changes are documented, and the author        */
+/* and date are updated to recognize each developer's contribution            */
+/* and maintain clear version tracking.                                       */
+/*                                                                            */
+/* Original Author: Nico Fontani                                              */
+/* Last Modified: 19 Oct 2026                                                 */
+/*                                                                            */
+/******************************************************************************/
+
+#ifndef __GARDEN_H
+#define __GARDEN_H
+
+#include <stdatomic.h>
+#include <sys/syscall.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#include "./Mutex.h"
+#include "./shared.h"
+#include "./shm_notify.h"
+
+#define MTX_KEY 4242        // Mutex key for synchronization
+#define SHM_KEY 4243        // Shared memory key for garden state
+
+#define N_CICLES 100        // Default number of cycles of the dogs and the owners
+
+#define GARDEN_MAX_STRIPES 4096
+#define GARDEN_CACHE_LINE  64
+
+// How the plates are protected
+typedef enum {
+    GARDEN_GLOBAL, GARDEN_STRIPED, GARDEN_LOCKFREE, GARDEN_BITSET
+} GardenMode;
+
+// Where the plates are placed on a NUMA machine
+typedef enum {
+    GARDEN_NUMA_NONE,       // Not asked for: no placement, no report
+    GARDEN_NUMA_OFF,        // Wherever the garden touches them first, with a report
+    GARDEN_NUMA_INTERLEAVE, // Spread page by page over all the nodes
+    GARDEN_NUMA_BIND        // Part k of the garden bound to node k, workers on its CPUs
+} GardenNuma;
+
+#define GARDEN_PRINT_MAX 1000   // Larger gardens only print their summary
+#define GARDEN_SEED      42     // Default seed of the benchmark mode
+
+#define GARDEN_SNAP_SHIFT 12    // Snapshots are copied 4096 plates at a time
+#define GARDEN_SNAP_BUSY  0x80000000u   // A chunk is being copied
+
+// Enum to represent the state of the plates (either CLEAN or POOP)
+typedef enum {
+    CLEAN, POOP
+} Plate;
+
+// One stripe lock, alone on its cache line
+typedef struct {
+    fmutex_t lock;
+} __attribute__((aligned(GARDEN_CACHE_LINE))) GardenStripe;
+
+// One transition made by a worker
+typedef struct {
+    int position;
+    Plate to;               // POOP for the dog, CLEAN for the owner
+} GardenOp;
+
+// Operation log of one worker, followed by log_len GardenOp
+typedef struct {
+    int pid;
+    int dog;                // 1 for a dog, 0 for an owner
+    int index;              // Among the dogs or the owners
+    int count;              // Transitions made (may exceed log_len)
+    long long ops;          // Cycles run by a dog, plates cleaned by an owner
+    long long first_ns;     // When the first cycle started (CLOCK_MONOTONIC)
+    int node;               // NUMA node the worker ran on
+    long local_pages;       // Pages of its partition on that node
+    long remote_pages;      // ... and on the other nodes
+    unsigned long long workload;               // Hash of the dog's random choices
+    uint64_t hist[MUTEX_STATS_BUCKETS];        // Time of each poop / clean, log2 of the cycles
+} __attribute__((aligned(GARDEN_CACHE_LINE))) GardenLog;
+
+// xoshiro256** generator, one per worker: unlike rand() it has no state
+// shared with anybody, and the same seed always gives the same sequence
+typedef struct {
+    uint64_t s[4];
+} GardenRandom;
+
+// One slot of the dirty-plate queue: a bounded MPMC ring where every slot
+// carries a sequence number telling whose turn it is (pusher or popper)
+typedef struct {
+    atomic_ullong seq;
+    int position;
+} GardenSlot;
+
+// Dirty-plate queue: push and pop ends on their own cache lines, then queue_len slots
+typedef struct {
+    atomic_ullong tail __attribute__((aligned(GARDEN_CACHE_LINE)));  // Next slot to push
+    atomic_ullong head __attribute__((aligned(GARDEN_CACHE_LINE)));  // Next slot to pop
+} GardenQueue;
+
+// Start of the shared memory segment
+typedef struct {
+    int n_plates;
+    int n_stripes;          // Only in GARDEN_STRIPED mode
+    int stripe_len;         // Plates per stripe
+    GardenMode mode;
+    int max_workers;        // Operation logs in the segment
+    int log_len;            // Entries of each log (0 = no logs)
+    int queue_len;          // Slots of the dirty-plate queue (0 = no queue)
+    int n_dogs;             // Workers, each on its own partition
+    int n_owners;
+    long long cycles;       // Cycles of each worker
+    int pin;                // Pin the workers to CPUs
+    GardenNuma numa;        // Set before garden_init(), which keeps it
+    int n_nodes;
+    int bench;              // Benchmark mode: no sleeps, seeded generators
+    unsigned long long seed;
+    atomic_int joined;      // Logs handed out so far
+    atomic_int dogs_joined; // Dogs that joined so far
+    int dogs_running;       // Dogs that had joined at the release: the owners wait for these
+    atomic_int dogs_done;   // Dogs that ran all their cycles: the owners stop after them
+    atomic_ullong poops;    // Total CLEAN -> POOP transitions
+    atomic_ullong cleans;   // Total POOP -> CLEAN transitions
+    shm_notify_t dirty;     // Published by the dog after every poop
+    shm_notify_t ready;     // Published by every worker that joins
+    shm_notify_t start;     // Published once, when the workers are released
+    int snapshots;          // Copy-on-write snapshots of the plates
+    int finished;           // Set by the garden when the workers are done
+    atomic_ullong snap_cows;        // Chunks copied by the workers themselves
+    atomic_uint snap_published;     // Last complete snapshot
+    atomic_uint snap_epoch __attribute__((aligned(GARDEN_CACHE_LINE)));  // Snapshot being taken
+} __attribute__((aligned(GARDEN_CACHE_LINE))) GardenHeader;
+
+size_t garden_align(size_t n) {
+    return (n + GARDEN_CACHE_LINE - 1) & ~(size_t)(GARDEN_CACHE_LINE - 1);
+}
+
+size_t garden_log_size(int log_len) {
+    return garden_align(sizeof(GardenLog) + sizeof(GardenOp) * log_len);
+}
+
+// Bytes taken by the plates: a Plate each, or one bit each
+size_t garden_plates_size(GardenMode mode, int n_plates) {
+    if (mode == GARDEN_BITSET) return garden_align(((size_t)n_plates + 63) / 64 * sizeof(uint64_t));
+    return garden_align(sizeof(Plate) * (size_t)n_plates);
+}
+
+// Queue slots for a garden: a power of two, with room for every plate at once
+int garden_queue_len(int n_plates) {
+    int len = 1;
+    while (len < n_plates) len <<= 1;
+    return len;
+}
+
+size_t garden_queue_size(int queue_len) {
+    if (queue_len == 0) return 0;
+    return garden_align(sizeof(GardenQueue) + sizeof(GardenSlot) * (size_t)queue_len);
+}
+
+int garden_snap_chunks(int n_plates) {
+    return (n_plates + (1 << GARDEN_SNAP_SHIFT) - 1) >> GARDEN_SNAP_SHIFT;
+}
+
+// Snapshot area: the epoch copied into every chunk, the workers changing every
+// chunk, then two copies of the plates
+size_t garden_snap_size(GardenMode mode, int n_plates, int snapshots) {
+    if (!snapshots) return 0;
+    return 2 * garden_align(sizeof(atomic_uint) * garden_snap_chunks(n_plates)) + 2 * garden_plates_size(mode, n_plates);
+}
+
+// Size of the shared memory segment
+size_t garden_size(int n_plates, GardenMode mode, int n_stripes, int max_workers, int log_len,
+                   int queue_len, int snapshots) {
+    if (mode != GARDEN_STRIPED) n_stripes = 0;
+    return sizeof(GardenHeader) + sizeof(GardenStripe) * n_stripes + garden_plates_size(mode, n_plates)
+        + garden_queue_size(queue_len) + garden_snap_size(mode, n_plates, snapshots)
+        + garden_log_size(log_len) * max_workers;
+}
+
+// Stripe locks, right after the header
+GardenStripe* garden_stripes(GardenHeader* garden) {
+    return (GardenStripe*)(garden + 1);
+}
+
+// Plates, right after the stripe locks
+Plate* garden_plates(GardenHeader* garden) {
+    return (Plate*)(garden_stripes(garden) + garden->n_stripes);
+}
+
+// Bitset of the dirty plates (GARDEN_BITSET), in place of the Plate array
+uint64_t* garden_bits(GardenHeader* garden) {
+    return (uint64_t*)garden_plates(garden);
+}
+
+size_t garden_words(GardenHeader* garden) {
+    return ((size_t)garden->n_plates + 63) / 64;
+}
+
+// State of a plate, whatever the layout
+Plate garden_plate(GardenHeader* garden, int position) {
+    if (garden->mode == GARDEN_BITSET)
+        return (__atomic_load_n(&garden_bits(garden)[position >> 6], __ATOMIC_RELAXED) >> (position & 63)) & 1 ? POOP : CLEAN;
+    return __atomic_load_n(&garden_plates(garden)[position], __ATOMIC_RELAXED);
+}
+
+// Dirty-plate queue, after the plates
+GardenQueue* garden_queue(GardenHeader* garden) {
+    return (GardenQueue*)((char*)garden_plates(garden) + garden_plates_size(garden->mode, garden->n_plates));
+}
+
+GardenSlot* garden_queue_slots(GardenQueue* queue) {
+    return (GardenSlot*)(queue + 1);
+}
+
+// Epoch of every chunk of the snapshots, after the queue
+atomic_uint* garden_snap_copied(GardenHeader* garden) {
+    return (atomic_uint*)((char*)garden_queue(garden) + garden_queue_size(garden->queue_len));
+}
+
+// Workers changing a plate of every chunk right now
+atomic_uint* garden_snap_writers(GardenHeader* garden) {
+    return (atomic_uint*)((char*)garden_snap_copied(garden) + garden_align(sizeof(atomic_uint) * garden_snap_chunks(garden->n_plates)));
+}
+
+// One of the two snapshot buffers: epoch e is copied into buffer e % 2
+char* garden_snap_buffer(GardenHeader* garden, unsigned epoch) {
+    char* buffers = (char*)garden_snap_writers(garden) + garden_align(sizeof(atomic_uint) * garden_snap_chunks(garden->n_plates));
+    return buffers + (epoch & 1) * garden_plates_size(garden->mode, garden->n_plates);
+}
+
+// Operation log of a worker, after the snapshots
+GardenLog* garden_log(GardenHeader* garden, int worker) {
+    char* logs = (char*)garden_snap_copied(garden) + garden_snap_size(garden->mode, garden->n_plates, garden->snapshots);
+    return (GardenLog*)(logs + garden_log_size(garden->log_len) * worker);
+}
+
+GardenOp* garden_log_ops(GardenLog* log) {
+    return (GardenOp*)(log + 1);
+}
+
+// Fill in the header of a new garden, initialize its locks and plates
+void garden_init(GardenHeader* garden, int n_plates, GardenMode mode, int n_stripes,
+                 int max_workers, int log_len, int queue_len, int snapshots) {
+    if (mode != GARDEN_STRIPED) n_stripes = 0;
+    garden->n_plates = n_plates;
+    garden->n_stripes = n_stripes;
+    garden->stripe_len = n_stripes ? (n_plates + n_stripes - 1) / n_stripes : n_plates;
+    garden->mode = mode;
+    garden->max_workers = max_workers;
+    garden->log_len = log_len;
+    garden->queue_len = queue_len;
+    garden->snapshots = snapshots;
+    garden->finished = 0;
+    atomic_init(&garden->snap_cows, 0);
+    atomic_init(&garden->snap_published, 0);
+    atomic_init(&garden->snap_epoch, 0);
+    garden->n_dogs = 1;
+    garden->n_owners = 1;
+    garden->cycles = N_CICLES;
+    garden->pin = 0;
+    garden->bench = 0;
+    garden->seed = GARDEN_SEED;
+    atomic_init(&garden->joined, 0);
+    atomic_init(&garden->dogs_joined, 0);
+    garden->dogs_running = 0;
+    atomic_init(&garden->dogs_done, 0);
+    atomic_init(&garden->poops, 0);
+    atomic_init(&garden->cleans, 0);
+    shm_notify_init(&garden->dirty);
+    shm_notify_init(&garden->ready);
+    shm_notify_init(&garden->start);
+    for (int s = 0; s < n_stripes; s++) {
+        fmutex_init(&garden_stripes(garden)[s].lock, 1);
+    }
+    garden->n_nodes = shared_numa_nodes();
+    if (garden->numa >= GARDEN_NUMA_INTERLEAVE) {
+        // Left to the dogs: each one first-touches (clears) its own partition
+    } else if (mode == GARDEN_BITSET) {
+        memset(garden_bits(garden), 0, garden_plates_size(mode, n_plates));
+    } else {
+        for (int i = 0; i < n_plates; i++) {
+            garden_plates(garden)[i] = CLEAN;
+        }
+    }
+    if (queue_len) {
+        GardenQueue* queue = garden_queue(garden);
+        atomic_init(&queue->tail, 0);
+        atomic_init(&queue->head, 0);
+        for (int k = 0; k < queue_len; k++) {
+            atomic_init(&garden_queue_slots(queue)[k].seq, k);
+            garden_queue_slots(queue)[k].position = -1;
+        }
+    }
+    if (snapshots) {
+        memset(garden_snap_copied(garden), 0, garden_snap_size(mode, n_plates, snapshots));
+    }
+    for (int w = 0; w < max_workers; w++) {
+        memset(garden_log(garden, w), 0, sizeof(GardenLog));
+    }
+}
+
+// Take the next free operation log (NULL if there is none left)
+GardenLog* garden_join(GardenHeader* garden, int dog, int index) {
+    int worker = atomic_fetch_add(&garden->joined, 1);
+    if (worker >= garden->max_workers) return NULL;
+    GardenLog* log = garden_log(garden, worker);
+    log->pid = getpid();
+    log->dog = dog;
+    log->index = index;
+    if (dog) atomic_fetch_add(&garden->dogs_joined, 1);
+    shm_notify_publish(&garden->ready);
+    return log;
+}
+
+long long garden_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Wait until `n` workers joined, at most timeout_ms; returns how many did
+int garden_wait_joined(GardenHeader* garden, int n, long timeout_ms) {
+    long long deadline = garden_now_ns() + timeout_ms * 1000000LL;
+    uint32_t seen = shm_notify_read(&garden->ready);
+    while (atomic_load(&garden->joined) < n) {
+        long left_ms = (long)((deadline - garden_now_ns()) / 1000000);
+        if (left_ms <= 0) break;
+        seen = shm_wait_change(&garden->ready, seen, left_ms);
+    }
+    return atomic_load(&garden->joined);
+}
+
+// Release the workers waiting in garden_wait_start(). The owners stop after
+// the dogs that joined by now: a dog that never starts can't keep them waiting
+// (one joining later still runs, but the owners may leave its last poops).
+void garden_release(GardenHeader* garden) {
+    garden->dogs_running = atomic_load(&garden->dogs_joined);
+    shm_notify_publish(&garden->start);
+}
+
+// All the dogs released with the owners are done
+int garden_dogs_done(GardenHeader* garden) {
+    return atomic_load(&garden->dogs_done) >= garden->dogs_running;
+}
+
+void garden_wait_start(GardenHeader* garden) {
+    while (shm_notify_read(&garden->start) == 0) shm_wait_change(&garden->start, 0, -1);
+}
+
+// Record how long a poop or a clean took, since `start` (mutex_stats_now())
+void garden_log_time(GardenLog* log, uint64_t start) {
+    if (log) log->hist[mutex_stats_bucket(mutex_stats_now() - start)]++;
+}
+
+// Fold a value into a 64-bit FNV-1a hash
+unsigned long long garden_hash(unsigned long long hash, uint64_t value) {
+    for (int i = 0; i < 8; i++) hash = (hash ^ ((value >> (8 * i)) & 0xff)) * 0x100000001b3ull;
+    return hash;
+}
+
+#define GARDEN_HASH_START 0xcbf29ce484222325ull
+
+// Hash of the state of every plate, the same whatever the layout
+unsigned long long garden_checksum(GardenHeader* garden) {
+    unsigned long long hash = GARDEN_HASH_START;
+    for (int i = 0; i < garden->n_plates; i++) hash = (hash ^ (garden_plate(garden, i) == POOP)) * 0x100000001b3ull;
+    return hash;
+}
+
+static inline uint64_t garden_rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+// Seed the generator of one worker: splitmix64 of the seed and the stream
+void garden_random_seed(GardenRandom* r, unsigned long long seed, int stream) {
+    uint64_t x = seed ^ (0x9e3779b97f4a7c15ull * (uint64_t)(stream + 1));
+    for (int i = 0; i < 4; i++) {
+        uint64_t z = (x += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        r->s[i] = z ^ (z >> 31);
+    }
+}
+
+uint64_t garden_random(GardenRandom* r) {
+    uint64_t* s = r->s;
+    uint64_t result = garden_rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = garden_rotl(s[3], 45);
+    return result;
+}
+
+// Contiguous partition of worker `index` out of n: plates [*first, *first + *count)
+void garden_partition(GardenHeader* garden, int index, int n, int* first, int* count) {
+    if (n <= 0 || index < 0 || index >= n) {
+        index = 0;
+        n = 1;
+    }
+    long long start = (long long)garden->n_plates * index / n;
+    long long end = (long long)garden->n_plates * (index + 1) / n;
+    *first = (int)start;
+    *count = (int)(end - start);
+}
+
+// Bytes of the plates holding [first, first + count)
+void garden_plates_range(GardenHeader* garden, int first, int count, size_t* offset, size_t* len) {
+    size_t end;
+    if (garden->mode == GARDEN_BITSET) {
+        *offset = (size_t)first / 64 * sizeof(uint64_t);
+        end = ((size_t)first + count + 63) / 64 * sizeof(uint64_t);
+    } else {
+        *offset = (size_t)first * sizeof(Plate);
+        end = ((size_t)first + count) * sizeof(Plate);
+    }
+    *len = end - *offset;
+}
+
+// Node owning a plate with GARDEN_NUMA_BIND: node k has part k of n_nodes
+int garden_node_of(GardenHeader* garden, int position) {
+    for (int k = 0; k < garden->n_nodes; k++) {
+        int first, count;
+        garden_partition(garden, k, garden->n_nodes, &first, &count);
+        if (position < first + count) return k;
+    }
+    return garden->n_nodes - 1;
+}
+
+// Place the plates on the nodes, before anybody touches them
+int garden_place(GardenHeader* garden) {
+    char* plates = (char*)garden_plates(garden);
+    size_t offset, len;
+    if (garden->numa == GARDEN_NUMA_INTERLEAVE) {
+        unsigned long all = garden->n_nodes >= SHARED_MAX_NODES ? ~0ul : (1ul << garden->n_nodes) - 1;
+        return shared_mbind(plates, garden_plates_size(garden->mode, garden->n_plates),
+                            SHARED_MPOL_INTERLEAVE, all, SHARED_MPOL_MF_MOVE);
+    }
+    if (garden->numa == GARDEN_NUMA_BIND) {
+        for (int k = 0; k < garden->n_nodes; k++) {
+            int first, count;
+            garden_partition(garden, k, garden->n_nodes, &first, &count);
+            garden_plates_range(garden, first, count, &offset, &len);
+            if (len && shared_mbind(plates + offset, len, SHARED_MPOL_BIND, 1ul << k, SHARED_MPOL_MF_MOVE) != 0)
+                return -1;
+        }
+    }
+    return 0;
+}
+
+// Where the pages of a worker's partition are, seen from the node it runs on
+void garden_numa_report(GardenHeader* garden, GardenLog* log, int first, int count) {
+    long pages_on_node[SHARED_MAX_NODES] = { 0 };
+    size_t offset, len;
+    if (!log || garden->numa == GARDEN_NUMA_NONE) return;
+    garden_plates_range(garden, first, count, &offset, &len);
+    shared_count_nodes((char*)garden_plates(garden) + offset, len, pages_on_node);
+    log->node = shared_current_node();
+    for (int k = 0; k < SHARED_MAX_NODES; k++) {
+        if (k == log->node) log->local_pages += pages_on_node[k];
+        else log->remote_pages += pages_on_node[k];
+    }
+}
+
+// Pin the calling process to a CPU (raw system call: no _GNU_SOURCE needed)
+int garden_pin(int cpu) {
+    unsigned long mask[1024 / (8 * sizeof(unsigned long))] = { 0 };
+    long n_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n_cpus <= 0) n_cpus = 1;
+    if (n_cpus > 1024) n_cpus = 1024;
+    cpu %= n_cpus;
+    mask[cpu / (8 * sizeof(unsigned long))] |= 1ul << (cpu % (8 * sizeof(unsigned long)));
+    return syscall(SYS_sched_setaffinity, 0, sizeof(mask), mask);
+}
+
+// Pin worker number `cpu` (dogs first, then owners) working on [first, first + count):
+// with GARDEN_NUMA_BIND on a CPU of the node that owns the middle of its plates
+int garden_pin_worker(GardenHeader* garden, int cpu, int first, int count) {
+    if (garden->numa == GARDEN_NUMA_BIND) {
+        int node_cpu = shared_node_cpu(garden_node_of(garden, first + count / 2), cpu);
+        if (node_cpu >= 0) return garden_pin(node_cpu);
+    }
+    return garden_pin(cpu);
+}
+
+// Stripe lock protecting a plate
+fmutex_t* garden_stripe_lock(GardenHeader* garden, int position) {
+    int stripe = position / garden->stripe_len;
+    if (stripe >= garden->n_stripes) stripe = garden->n_stripes - 1;
+    return &garden_stripes(garden)[stripe].lock;
+}
+
+// Copy one chunk of the plates into the snapshot `epoch`, unless it already
+// is there: whoever comes first (the monitor, or a worker about to change a
+// plate of the chunk) copies it, the others wait for that copy only.
+// The caller must not be among the writers of the chunk (garden_snap_enter).
+// RETURNS: 1 if this call made the copy
+int garden_snap_copy(GardenHeader* garden, int chunk, unsigned epoch) {
+    atomic_uint* copied = &garden_snap_copied(garden)[chunk];
+    atomic_uint* writers = &garden_snap_writers(garden)[chunk];
+    unsigned cur = atomic_load(copied);
+
+    for (;;) {
+        if (!(cur & GARDEN_SNAP_BUSY) && cur >= epoch) return 0;  // Already in this snapshot (or a later one)
+        if (cur & GARDEN_SNAP_BUSY) {
+            cpu_relax();  // Somebody else is copying it: one chunk, a few microseconds at most
+            cur = atomic_load(copied);
+        } else if (atomic_compare_exchange_weak(copied, &cur, epoch | GARDEN_SNAP_BUSY)) {
+            break;
+        }
+    }
+
+    // Writers that read an older epoch finish their change first: it belongs
+    // to the previous state. The ones coming next see the new epoch and wait.
+    while (atomic_load_explicit(writers, memory_order_acquire)) cpu_relax();
+
+    // The chunk as it is right now: its next change waits for this copy
+    size_t size = garden_plates_size(garden->mode, garden->n_plates);
+    size_t chunk_size = garden->mode == GARDEN_BITSET ? (1 << GARDEN_SNAP_SHIFT) / 8 : sizeof(Plate) << GARDEN_SNAP_SHIFT;
+    size_t offset = chunk_size * chunk;
+    size_t end = offset + chunk_size < size ? offset + chunk_size : size;
+    uint64_t* from = (uint64_t*)((char*)garden_plates(garden) + offset);
+    uint64_t* to = (uint64_t*)(garden_snap_buffer(garden, epoch) + offset);
+    for (size_t i = 0; i < (end - offset) / sizeof(uint64_t); i++) to[i] = __atomic_load_n(&from[i], __ATOMIC_ACQUIRE);
+
+    atomic_store(copied, epoch);
+    return 1;
+}
+
+// Enter a chunk before changing one of its plates. The epoch is read once
+// inside, so either the chunk is already in the current snapshot, or its copy
+// waits for garden_snap_leave(): the change lands on the side of the snapshot
+// its epoch says. A chunk not copied yet is copied first, from outside.
+// RETURNS: 1 if this call made a copy
+int garden_snap_enter(GardenHeader* garden, int chunk) {
+    atomic_uint* copied = &garden_snap_copied(garden)[chunk];
+    atomic_uint* writers = &garden_snap_writers(garden)[chunk];
+    int copies = 0;
+
+    for (;;) {
+        atomic_fetch_add(writers, 1);
+        unsigned epoch = atomic_load(&garden->snap_epoch);
+        unsigned cur = atomic_load(copied);
+        if (!(cur & GARDEN_SNAP_BUSY) && cur >= epoch) return copies;
+        atomic_fetch_sub(writers, 1);  // Whoever copies it waits for the writers
+        copies |= garden_snap_copy(garden, chunk, epoch);
+    }
+}
+
+void garden_snap_leave(GardenHeader* garden, int chunk) {
+    atomic_fetch_sub_explicit(&garden_snap_writers(garden)[chunk], 1, memory_order_release);
+}
+
+// Take a snapshot (one taker at a time, e.g. the monitor). The workers are not
+// stopped: a worker that changes a plate not yet copied copies its chunk first,
+// and a chunk is copied once the changes begun before the snapshot are done.
+// So the snapshot holds exactly the changes whose worker entered the chunk
+// before it started (garden_snap_enter), and none of the others.
+// RETURNS: The plates as they were (a Plate array, or bits in GARDEN_BITSET),
+//          valid until the next snapshot but one.
+const void* garden_snapshot(GardenHeader* garden) {
+    unsigned epoch = atomic_fetch_add(&garden->snap_epoch, 1) + 1;
+    for (int c = 0; c < garden_snap_chunks(garden->n_plates); c++) {
+        garden_snap_copy(garden, c, epoch);  // Waits for the chunks copied by the workers too
+    }
+    atomic_store(&garden->snap_published, epoch);
+    return garden_snap_buffer(garden, epoch);
+}
+
+// Dirty plates in a snapshot
+long long garden_snap_count_dirty(GardenHeader* garden, const void* snapshot) {
+    long long dirty = 0;
+    if (garden->mode == GARDEN_BITSET) {
+        const uint64_t* bits = snapshot;
+        for (size_t i = 0; i < garden_words(garden); i++) dirty += __builtin_popcountll(bits[i]);
+    } else {
+        const Plate* plates = snapshot;
+        for (int i = 0; i < garden->n_plates; i++) dirty += plates[i] == POOP;
+    }
+    return dirty;
+}
+
+// Lock whatever protects a plate: its stripe, or the global mutex
+void garden_lock(GardenHeader* garden, int mtx_id, int position) {
+    if (garden->n_stripes) fmutex_lock(garden_stripe_lock(garden, position));
+    else mutex_lock(mtx_id);
+}
+
+void garden_unlock(GardenHeader* garden, int mtx_id, int position) {
+    if (garden->n_stripes) fmutex_unlock(garden_stripe_lock(garden, position));
+    else mutex_unlock(mtx_id);
+}
+
+// Move a plate from one state to the other; returns 1 if this call changed it
+int garden_transition(GardenHeader* garden, int mtx_id, GardenLog* log, int position,
+                      Plate from, Plate to) {
+    Plate* plate = garden_plates(garden) + position;
+    int changed = 0;
+    if (position < 0 || position >= garden->n_plates) return 0;
+
+    // A snapshot is being taken: the chunk goes into it before it changes
+    if (garden->snapshots && garden_snap_enter(garden, position >> GARDEN_SNAP_SHIFT))
+        atomic_fetch_add_explicit(&garden->snap_cows, 1, memory_order_relaxed);
+
+    if (garden->mode == GARDEN_BITSET) {
+        // One atomic OR / AND: the old word tells whether this call flipped the bit
+        _Atomic uint64_t* word = (_Atomic uint64_t*)&garden_bits(garden)[position >> 6];
+        uint64_t bit = 1ull << (position & 63);
+        if (to == POOP) changed = !(atomic_fetch_or_explicit(word, bit, memory_order_acq_rel) & bit);
+        else changed = (atomic_fetch_and_explicit(word, ~bit, memory_order_acq_rel) & bit) != 0;
+    } else if (garden->mode == GARDEN_LOCKFREE) {
+        // One CAS, no lock: only one worker can win a given transition
+        changed = atomic_compare_exchange_strong_explicit((_Atomic Plate*)plate, &from, to,
+                                                          memory_order_acq_rel, memory_order_relaxed);
+    } else {
+        garden_lock(garden, mtx_id, position);
+        if (*plate == from) {
+            *plate = to;
+            changed = 1;
+        }
+        garden_unlock(garden, mtx_id, position);
+    }
+    if (garden->snapshots) garden_snap_leave(garden, position >> GARDEN_SNAP_SHIFT);
+
+    if (changed) {
+        atomic_fetch_add_explicit(to == POOP ? &garden->poops : &garden->cleans, 1, memory_order_relaxed);
+        if (log) {
+            if (log->count < garden->log_len) {
+                garden_log_ops(log)[log->count].position = position;
+                garden_log_ops(log)[log->count].to = to;
+            }
+            log->count++;
+        }
+    }
+    return changed;
+}
+
+// Push a dirty plate on the queue; returns 0 if the queue is full.
+// A plate is pushed only by the poop that dirtied it and popped before it is
+// cleaned, so a queue with a slot per plate never fills up.
+int garden_queue_push(GardenHeader* garden, int position) {
+    GardenQueue* queue = garden_queue(garden);
+    unsigned long long mask = garden->queue_len - 1;
+    unsigned long long pos = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    GardenSlot* slot;
+
+    for (;;) {
+        slot = &garden_queue_slots(queue)[pos & mask];
+        unsigned long long seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        long long diff = (long long)(seq - pos);
+        if (diff == 0) {
+            // The slot is free for this lap: claim it
+            if (atomic_compare_exchange_weak_explicit(&queue->tail, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed))
+                break;
+        } else if (diff < 0) {
+            return 0;  // Still holds the entry of the previous lap: full
+        } else {
+            pos = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+        }
+    }
+    slot->position = position;
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);  // Hand it to the poppers
+    return 1;
+}
+
+// Pop the oldest dirty plate, -1 if the queue is empty
+int garden_queue_pop(GardenHeader* garden) {
+    GardenQueue* queue = garden_queue(garden);
+    unsigned long long mask = garden->queue_len - 1;
+    unsigned long long pos = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    GardenSlot* slot;
+
+    for (;;) {
+        slot = &garden_queue_slots(queue)[pos & mask];
+        unsigned long long seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        long long diff = (long long)(seq - (pos + 1));
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&queue->head, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed))
+                break;
+        } else if (diff < 0) {
+            return -1;  // Not pushed yet: empty
+        } else {
+            pos = atomic_load_explicit(&queue->head, memory_order_relaxed);
+        }
+    }
+    int position = slot->position;
+    atomic_store_explicit(&slot->seq, pos + mask + 1, memory_order_release);  // Free for the next lap
+    return position;
+}
+
+// Entries in the queue right now
+long long garden_queue_count(GardenHeader* garden) {
+    GardenQueue* queue = garden_queue(garden);
+    return (long long)(atomic_load(&queue->tail) - atomic_load(&queue->head));
+}
+
+// The dog poops on a clean plate, queues it, and wakes the owner if it was waiting
+int garden_poop(GardenHeader* garden, int mtx_id, GardenLog* log, int position) {
+    int changed = garden_transition(garden, mtx_id, log, position, CLEAN, POOP);
+    if (changed && garden->queue_len) garden_queue_push(garden, position);
+    if (changed) shm_notify_publish(&garden->dirty);
+    return changed;
+}
+
+// Number of dirty plates right now
+long long garden_dirty_count(GardenHeader* garden) {
+    return (long long)(atomic_load_explicit(&garden->poops, memory_order_acquire)
+                       - atomic_load_explicit(&garden->cleans, memory_order_acquire));
+}
+
+// The owner cleans a dirty plate
+int garden_clean(GardenHeader* garden, int mtx_id, GardenLog* log, int position) {
+    return garden_transition(garden, mtx_id, log, position, POOP, CLEAN);
+}
+
+// First non-zero word in [i, n), n if none
+size_t garden_scan_words(const uint64_t* bits, size_t i, size_t n) {
+    while (i < n && __atomic_load_n(&bits[i], __ATOMIC_RELAXED) == 0) i++;
+    return i;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// Same, 4 words (256 plates) per test. The words may change meanwhile: a
+// stale result only sends the owner to a plate that is already clean
+__attribute__((target("avx2")))
+size_t garden_scan_words_avx2(const uint64_t* bits, size_t i, size_t n) {
+    for (; i + 4 <= n; i += 4) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(bits + i));
+        if (!_mm256_testz_si256(v, v)) break;
+    }
+    return garden_scan_words(bits, i, n);
+}
+#endif
+
+// Scanner for this CPU, chosen on the first call
+size_t (*garden_scan)(const uint64_t*, size_t, size_t);
+
+void garden_scan_select(void) {
+    garden_scan = garden_scan_words;
+#if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("avx2")) garden_scan = garden_scan_words_avx2;
+#endif
+}
+
+// First dirty plate in [from, end) of a bitset garden, -1 if none
+int garden_find_dirty(GardenHeader* garden, int from, int end) {
+    uint64_t* bits = garden_bits(garden);
+    if (end > garden->n_plates) end = garden->n_plates;
+    if (from < 0 || from >= end) return -1;
+    size_t n = ((size_t)end + 63) / 64;
+    if (!garden_scan) garden_scan_select();
+
+    // The first word only counts from `from` on
+    size_t i = (size_t)from >> 6;
+    uint64_t word = __atomic_load_n(&bits[i], __ATOMIC_RELAXED) & (~0ull << (from & 63));
+    while (!word) {
+        i = garden_scan(bits, i + 1, n);
+        if (i == n) return -1;
+        word = __atomic_load_n(&bits[i], __ATOMIC_RELAXED);
+    }
+    int position = (int)(i * 64 + __builtin_ctzll(word));  // tzcnt
+    return position < end ? position : -1;
+}
+
+// Next dirty plate of [first, end) after `position`, wrapping around; -1 if it is clean
+int garden_next_dirty(GardenHeader* garden, int position, int first, int end) {
+    int next = garden_find_dirty(garden, position + 1, end);
+    if (next < 0) next = garden_find_dirty(garden, first, end);
+    return next;
+}
+
+// Dirty plates, counted from the garden itself (popcount in bitset mode)
+long long garden_count_dirty(GardenHeader* garden) {
+    long long dirty = 0;
+    if (garden->mode == GARDEN_BITSET) {
+        uint64_t* bits = garden_bits(garden);
+        for (size_t i = 0; i < garden_words(garden); i++) dirty += __builtin_popcountll(bits[i]);
+    } else {
+        for (int i = 0; i < garden->n_plates; i++) dirty += garden_plates(garden)[i] == POOP;
+    }
+    return dirty;
+}
+
+#define IDLE_MS 1  // Longest nap of an owner when there is nothing to clean
+
+// The dog: runs around its part of the garden and randomly poops on the plates.
+// The same loop runs in a dog process or in a thread of the garden.
+void garden_dog(GardenHeader* garden, int mtx_id, int index) {
+    // Every dog runs around its own part of the garden, on its own CPU
+    int first, count;
+    garden_partition(garden, index, garden->n_dogs, &first, &count);
+    if (garden->pin || garden->numa == GARDEN_NUMA_BIND) garden_pin_worker(garden, index, first, count);
+
+    // NUMA placement: the dog touches its plates first, from its own node
+    if (garden->numa >= GARDEN_NUMA_INTERLEAVE) {
+        size_t offset, len;
+        garden_plates_range(garden, first, count, &offset, &len);
+        memset((char*)garden_plates(garden) + offset, 0, len);
+    }
+    GardenLog* log = garden_join(garden, 1, index);  // Where the dog logs what it did (and says it is ready)
+
+    // Benchmark mode: the dog's own generator, seeded by the garden, so every
+    // run makes the same choices; otherwise rand() seeded with the process ID
+    GardenRandom rng;
+    garden_random_seed(&rng, garden->seed, index);
+    srand(getpid());
+    int bench = garden->bench;
+
+    int position = first + count / 2;  // Start at the middle of the plates
+
+    // Wait until the garden releases the dog
+    garden_wait_start(garden);
+    if (log) log->first_ns = garden_now_ns();
+
+    printf("[%d] Dog is running around...\n", getpid());
+
+    // Run the simulation for the garden's number of cycles
+    long long cycles = garden->cycles;
+    for (long long i = 0; i < cycles; i++) {
+        position++;  // Move to the next position
+        if (position >= first + count) position = first;  // Wrap around at the end of the dog's plates
+
+        int poop = bench ? (int)(garden_random(&rng) >> 63) : rand() % 2;
+        if (poop) {  // Randomly decide if the dog will poop on the plate
+            if (log) log->workload = garden_hash(log->workload, position);
+            uint64_t start = mutex_stats_now();
+            garden_poop(garden, mtx_id, log, position);  // Locks the plate's stripe or the garden, or uses a CAS
+            garden_log_time(log, start);
+        }
+
+        if (!bench) usleep(100);  // Simulate a short delay before the next action
+    }
+    if (log) log->ops = cycles;
+    garden_numa_report(garden, log, first, count);
+
+    // Tell the owners: they finish once every dog is done and their plates are clean
+    atomic_fetch_add(&garden->dogs_done, 1);
+    shm_notify_publish(&garden->dirty);
+
+    printf("[%d] Dog is calm now...\n", getpid());  // Print when the dog has finished
+}
+
+// The owner: cleans the plates marked as POOP, sleeping when its plates are clean.
+// The same loop runs in an owner process or in a thread of the garden.
+void garden_owner(GardenHeader* garden, int mtx_id, int index) {
+    GardenLog* log = garden_join(garden, 0, index);
+    int n_plates = garden->n_plates;
+
+    // Every owner looks after its own part of the garden, on its own CPU
+    // (the CPUs after the dogs' ones)
+    int first, count;
+    garden_partition(garden, index, garden->n_owners, &first, &count);
+    if (garden->pin || garden->numa == GARDEN_NUMA_BIND) garden_pin_worker(garden, garden->n_dogs + index, first, count);
+
+    // Initialize the owner's position
+    int position = first;
+
+    // Wait until the garden lets the owner in
+    garden_wait_start(garden);
+    if (log) log->first_ns = garden_now_ns();
+
+    // Owner's cleaning loop
+    printf("[%d] Owner is cleaning around...\n", getpid());
+    long long cleaned = 0;
+    if (garden->queue_len) {
+        // Pop the next dirty plate straight from the queue: no sweeping, and no
+        // lock taken on a clean plate. Drain it until the dogs are done and it
+        // is empty; in between, wait for a poop (in benchmark mode too).
+        for (;;) {
+            int dogs_done = garden_dogs_done(garden);
+            uint32_t seen = shm_notify_read(&garden->dirty);  // Both read before the pop
+            int next = garden_queue_pop(garden);
+            if (next < 0) {
+                if (dogs_done) break;  // Every push came before the dogs were done
+                shm_wait_change(&garden->dirty, seen, IDLE_MS);
+                continue;
+            }
+            uint64_t start = mutex_stats_now();
+            cleaned += garden_clean(garden, mtx_id, log, next);
+            garden_log_time(log, start);
+        }
+    } else {
+        // Sweep the owner's plates until the dogs are done and a whole sweep,
+        // started after that, found nothing left to clean
+        int idle = 0;  // Clean plates seen in a row
+        int dogs_done = garden_dogs_done(garden);
+        uint32_t seen = shm_notify_read(&garden->dirty);  // Both read before the sweep starts
+        for (;;) {
+            int next = position;
+            if (garden->mode == GARDEN_BITSET) {
+                // Jump straight to the next dirty plate: whole words of clean plates
+                // are skipped at once (tzcnt, AVX2). Own plates first, then steal
+                // from the other owners' parts of the garden.
+                next = garden_next_dirty(garden, position, first, first + count);
+                if (next < 0) next = garden_next_dirty(garden, position, 0, n_plates);
+                if (next < 0) idle = count;  // Nothing dirty anywhere: as good as a whole sweep
+            } else if (count == 0) {
+                next = -1;  // More owners than plates: none of its own
+            } else {
+                next++;  // Move to the next plate
+                if (next >= first + count) next = first;  // Wrap around at the end of the owner's plates
+            }
+
+            // If the plate is marked as 'POOP', clean it (under the stripe or garden
+            // lock, with a CAS in lockfree mode, an atomic AND in bitset mode).
+            // A plate that looks clean is skipped: no lock taken for nothing.
+            if (next >= 0) {
+                position = next;
+                int changed = 0;
+                if (garden_plate(garden, position) == POOP) {
+                    uint64_t start = mutex_stats_now();
+                    changed = garden_clean(garden, mtx_id, log, position);
+                    garden_log_time(log, start);
+                }
+                if (changed) {
+                    cleaned++;
+                    idle = 0;
+                    dogs_done = garden_dogs_done(garden);
+                    seen = shm_notify_read(&garden->dirty);
+                    continue;
+                }
+                idle++;
+            }
+
+            // A whole sweep of the owner's plates found nothing: done if the dogs
+            // were, otherwise sleep until a dog publishes a poop (instead of
+            // walking the garden at full speed). Benchmark mode sleeps too: the
+            // wait spins first, and a spinning owner would take the dogs' CPUs.
+            if (idle >= count) {
+                if (dogs_done) break;
+                shm_wait_change(&garden->dirty, seen, IDLE_MS);
+                idle = 0;
+                dogs_done = garden_dogs_done(garden);
+                seen = shm_notify_read(&garden->dirty);
+            }
+        }
+    }
+    if (log) log->ops = cleaned;
+    garden_numa_report(garden, log, first, count);
+
+    // Print a message when the owner is done cleaning
+    printf("[%d] Owner can take a break, now.\n", getpid());
+}
+
+// Map the garden and the mutex handed over by the launcher (posix_spawn mode):
+// the segment is a file descriptor inherited from the garden, no IPC key lookup
+GardenHeader* garden_attach_fd(int fd, int mtx_id) {
+    struct stat st;
+    if (fstat(fd, &st) != 0) return NULL;
+#ifdef MUTEX_FUTEX
+    if (!mutex_futex_get(mtx_id) && mutex_futex_attach(mtx_id) == -1) return NULL;
+#else
+    (void)mtx_id;
+#endif
+    return shared_map_fd(fd, (size_t)st.st_size, 0);
+}
+
+#endif /* __GARDEN_H */
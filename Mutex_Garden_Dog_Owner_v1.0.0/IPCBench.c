@@ -0,0 +1,385 @@
+/******************************************************************************/
+/*                                                                            */
+/*                          IPC PRIMITIVES BENCHMARK                          */
+/*                                                                            */
+/* DESCRIPTION:                                                               */
+/* This program measures the synchronization primitives available to our     */
+/* processes, all placed in one shared memory segment (shared.h):            */
+/*  - locks: mutex_lock() of Mutex.h (SysV unless -DMUTEX_FUTEX), a pshared  */
+/*    pthread mutex, the futex lock fmutex_t and a POSIX sem_t as a mutex,   */
+/*    uncontended and with N processes fighting for them;                     */
+/*  - messages: ping-pong between 2 processes by spinning on shared memory,  */
+/*    by futex, by POSIX sem_t and by SysV semaphores, plus the one-way      */
+/*    latency of a store seen by a spinning process.                         */
+/* Every scenario runs with the processes free to move and pinned to CPUs.   */
+/* Times are taken with the TSC, results are ns/op and percentiles.          */
+/*                                                                            */
+/* Copyright (c) 2026, Nico Fontani                                           */
+/* Creation Date: 19 Oct 2026                                                 */
+/*                                                                            */
+/* This code was developed by Nico Fontani. Its use and modification are      */
+/* permitted, provided that any changes are documented, and the author        */
+/* and date are updated to recognize each developer's contribution            */
+/* and maintain clear version tracking.                                       */
+/*                                                                            */
+/* Original Author: Nico Fontani                                              */
+/* Last Modified: 19 Oct 2026                                                 */
+/*                                                                            */
+/******************************************************************************/
+
+#define _GNU_SOURCE  // sched_setaffinity() and CPU_SET()
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <sys/wait.h>
+
+#include "./Mutex.h"
+#include "./shared.h"
+
+#define MAX_PROCS    64
+#define HIST_SUB     8                   // Buckets per power of two
+#define HIST_BUCKETS (64 * HIST_SUB)
+#define YIELD_EVERY  64                  // Spins before giving the CPU away
+
+enum { LOCK_SYSV, LOCK_PTHREAD, LOCK_FUTEX, LOCK_SEM, N_LOCKS };
+const char* lock_names[] = { "mutex_lock", "pthread mutex", "fmutex", "sem_t" };
+
+enum { PP_SPIN, PP_FUTEX, PP_SEM, PP_SYSV, N_PINGPONG };
+const char* pingpong_names[] = { "spin", "futex", "sem_t", "sysv sem" };
+
+// Samples of one process
+typedef struct {
+    uint64_t ops;
+    uint64_t hist[HIST_BUCKETS];
+} __attribute__((aligned(64))) Result;
+
+// Everything the processes share
+typedef struct {
+    pthread_mutex_t pmtx;
+    sem_t           sem;
+    fmutex_t        fmtx;
+    sem_t           ping_sem, pong_sem;
+    uint64_t        ping __attribute__((aligned(64)));
+    uint64_t        ping_time;
+    uint32_t        ping_word;
+    uint64_t        pong __attribute__((aligned(64)));
+    uint32_t        pong_word;
+    int             start __attribute__((aligned(64)));
+    int             stop;
+    uint32_t        last;          // Number of the last ping-pong message
+    Result          results[MAX_PROCS];
+} Bench;
+
+Bench* bench;
+int sysv_mtx;         // SysV mutex (one semaphore)
+int sysv_pingpong;    // SysV set of two semaphores
+double ticks_per_ns;
+int n_cpus;
+
+/*                      Timing                      */
+
+uint64_t now_ticks(void) {
+    return mutex_stats_now();
+}
+
+// Bucket of a duration in ticks: 8 buckets per power of two
+int hist_bucket(uint64_t ticks) {
+    if (ticks < HIST_SUB) return (int)ticks;
+    int log = 63 - __builtin_clzll(ticks);
+    int sub = (int)((ticks >> (log - 3)) & (HIST_SUB - 1));
+    return (log - 2) * HIST_SUB + sub;
+}
+
+// Upper bound of a bucket, in ticks
+double hist_upper(int bucket) {
+    if (bucket < HIST_SUB) return bucket + 1;
+    int log = bucket / HIST_SUB + 2;
+    int sub = bucket % HIST_SUB;
+    return (double)(1ull << log) * (1.0 + (sub + 1) / (double)HIST_SUB);
+}
+
+void record(Result* r, uint64_t ticks) {
+    r->hist[hist_bucket(ticks)]++;
+    r->ops++;
+}
+
+// Percentile (ns) of the samples of processes [0, n)
+double percentile(int n, double fraction) {
+    uint64_t total = 0, seen = 0;
+    for (int p = 0; p < n; p++) total += bench->results[p].ops;
+    if (total == 0) return 0;
+    for (int b = 0; b < HIST_BUCKETS; b++) {
+        for (int p = 0; p < n; p++) seen += bench->results[p].hist[b];
+        if (seen >= fraction * total) return hist_upper(b) / ticks_per_ns;
+    }
+    return 0;
+}
+
+/*                      Processes                      */
+
+void pin(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % n_cpus, &set);
+    sched_setaffinity(0, sizeof(set), &set);
+}
+
+// Busy wait for a condition without starving the other process on one CPU
+#define SPIN_UNTIL(cond)                                     \
+    for (unsigned spins_ = 0; !(cond); spins_++) {           \
+        cpu_relax();                                         \
+        if (spins_ % YIELD_EVERY == YIELD_EVERY - 1)         \
+            sched_yield();                                   \
+    }
+
+// Fork n workers running fn(id), let them run for `millis`, wait for them.
+// Returns the elapsed seconds.
+double run_workers(int n, int pinned, int millis, void (*fn)(int, uint64_t)) {
+    bench->start = 0;
+    bench->stop = 0;
+    memset(bench->results, 0, sizeof(bench->results));
+    uint64_t duration = (uint64_t)(millis * 1e6 * ticks_per_ns);
+
+    fflush(stdout);
+    for (int id = 0; id < n; id++) {
+        if (!fork()) {
+            if (pinned) pin(id);
+            __atomic_fetch_add(&bench->start, 1, __ATOMIC_SEQ_CST);
+            SPIN_UNTIL(__atomic_load_n(&bench->start, __ATOMIC_ACQUIRE) > n);
+            fn(id, duration);
+            exit(0);
+        }
+    }
+
+    SPIN_UNTIL(__atomic_load_n(&bench->start, __ATOMIC_ACQUIRE) == n);
+    uint64_t t0 = now_ticks();
+    __atomic_store_n(&bench->start, n + 1, __ATOMIC_RELEASE);
+    usleep(millis * 1000);
+    __atomic_store_n(&bench->stop, 1, __ATOMIC_RELEASE);
+    while (wait(NULL) > 0)
+        ;
+    return (now_ticks() - t0) / ticks_per_ns / 1e9;
+}
+
+/*                      Locks                      */
+
+int lock_kind;
+
+void do_lock(void) {
+    switch (lock_kind) {
+    case LOCK_SYSV:    mutex_lock(sysv_mtx); break;
+    case LOCK_PTHREAD: pthread_mutex_lock(&bench->pmtx); break;
+    case LOCK_FUTEX:   fmutex_lock(&bench->fmtx); break;
+    case LOCK_SEM:     while (sem_wait(&bench->sem) == -1 && errno == EINTR); break;
+    }
+}
+
+void do_unlock(void) {
+    switch (lock_kind) {
+    case LOCK_SYSV:    mutex_unlock(sysv_mtx); break;
+    case LOCK_PTHREAD: pthread_mutex_unlock(&bench->pmtx); break;
+    case LOCK_FUTEX:   fmutex_unlock(&bench->fmtx); break;
+    case LOCK_SEM:     sem_post(&bench->sem); break;
+    }
+}
+
+// One lock + unlock per sample, until stop
+void lock_worker(int id, uint64_t duration) {
+    Result* r = &bench->results[id];
+    (void)duration;
+    while (!__atomic_load_n(&bench->stop, __ATOMIC_RELAXED)) {
+        uint64_t t0 = now_ticks();
+        do_lock();
+        do_unlock();
+        record(r, now_ticks() - t0);
+    }
+}
+
+void bench_lock(int kind, int n, int pinned, int millis) {
+    lock_kind = kind;
+    double seconds = run_workers(n, pinned, millis, lock_worker);
+    uint64_t ops = 0;
+    for (int p = 0; p < n; p++) ops += bench->results[p].ops;
+
+    // ns/op: wall time per completed lock + unlock, all processes together
+    printf("%-14s %5d %-8s %10.1f %10.0f %10.0f %10.0f %10.0f\n", lock_names[kind], n,
+           pinned ? "pinned" : "free", ops ? seconds * 1e9 / ops : 0.0,
+           percentile(n, 0.5), percentile(n, 0.99), percentile(n, 0.999), percentile(n, 0.9999));
+}
+
+/*                      Ping-pong                      */
+
+int pingpong_kind;
+
+// Process 0 sends, process 1 answers; process 0 records the round trips
+void pingpong_worker(int id, uint64_t duration) {
+    Result* r = &bench->results[0];
+    uint64_t end = now_ticks() + duration;
+    struct sembuf up[2] = { { 0, +1, 0 }, { 1, +1, 0 } };
+    struct sembuf down[2] = { { 0, -1, 0 }, { 1, -1, 0 } };
+
+    for (uint32_t i = 1;; i++) {
+        if (id == 0) {
+            // The answering process stops after the message marked as the last
+            int last = now_ticks() >= end;
+            if (last) __atomic_store_n(&bench->last, i, __ATOMIC_RELEASE);
+            uint64_t t0 = now_ticks();
+            switch (pingpong_kind) {
+            case PP_SPIN:
+                __atomic_store_n(&bench->ping, i, __ATOMIC_RELEASE);
+                SPIN_UNTIL(__atomic_load_n(&bench->pong, __ATOMIC_ACQUIRE) == i);
+                break;
+            case PP_FUTEX:
+                __atomic_store_n(&bench->ping_word, i, __ATOMIC_RELEASE);
+                futex_wake(&bench->ping_word, 1);
+                while (__atomic_load_n(&bench->pong_word, __ATOMIC_ACQUIRE) != i)
+                    futex_wait(&bench->pong_word, i - 1, NULL);
+                break;
+            case PP_SEM:
+                sem_post(&bench->ping_sem);
+                while (sem_wait(&bench->pong_sem) == -1 && errno == EINTR);
+                break;
+            case PP_SYSV:
+                sem_ops_batch(sysv_pingpong, &up[0], 1);
+                sem_ops_batch(sysv_pingpong, &down[1], 1);
+                break;
+            }
+            if (last) return;
+            record(r, now_ticks() - t0);
+        } else {
+            switch (pingpong_kind) {
+            case PP_SPIN:
+                SPIN_UNTIL(__atomic_load_n(&bench->ping, __ATOMIC_ACQUIRE) == i);
+                __atomic_store_n(&bench->pong, i, __ATOMIC_RELEASE);
+                break;
+            case PP_FUTEX:
+                while (__atomic_load_n(&bench->ping_word, __ATOMIC_ACQUIRE) != i)
+                    futex_wait(&bench->ping_word, i - 1, NULL);
+                __atomic_store_n(&bench->pong_word, i, __ATOMIC_RELEASE);
+                futex_wake(&bench->pong_word, 1);
+                break;
+            case PP_SEM:
+                while (sem_wait(&bench->ping_sem) == -1 && errno == EINTR);
+                sem_post(&bench->pong_sem);
+                break;
+            case PP_SYSV:
+                sem_ops_batch(sysv_pingpong, &down[0], 1);
+                sem_ops_batch(sysv_pingpong, &up[1], 1);
+                break;
+            }
+            if (__atomic_load_n(&bench->last, __ATOMIC_ACQUIRE) == i) return;
+        }
+    }
+}
+
+// Process 0 stores a time stamp, process 1 spins until it sees it
+void oneway_worker(int id, uint64_t duration) {
+    Result* r = &bench->results[0];
+    uint64_t end = now_ticks() + duration;
+
+    for (uint64_t i = 1;; i++) {
+        if (id == 0) {
+            // Wait for the previous message to be seen, so they don't queue up
+            SPIN_UNTIL(__atomic_load_n(&bench->pong, __ATOMIC_ACQUIRE) == i - 1);
+            int last = now_ticks() >= end;
+            __atomic_store_n(&bench->ping_time, now_ticks(), __ATOMIC_RELAXED);
+            __atomic_store_n(&bench->ping, last ? UINT64_MAX : i, __ATOMIC_RELEASE);
+            if (last) return;
+        } else {
+            uint64_t seen;
+            SPIN_UNTIL((seen = __atomic_load_n(&bench->ping, __ATOMIC_ACQUIRE)) >= i);
+            if (seen == UINT64_MAX) return;
+            record(r, now_ticks() - __atomic_load_n(&bench->ping_time, __ATOMIC_RELAXED));
+            __atomic_store_n(&bench->pong, i, __ATOMIC_RELEASE);
+        }
+    }
+}
+
+void reset_pingpong(void) {
+    bench->ping = bench->pong = 0;
+    bench->last = 0;
+    bench->ping_word = bench->pong_word = 0;
+    sem_init(&bench->ping_sem, 1, 0);
+    sem_init(&bench->pong_sem, 1, 0);
+    semctl(sysv_pingpong, 0, SETVAL, 0);
+    semctl(sysv_pingpong, 1, SETVAL, 0);
+}
+
+void print_message_row(const char* name, int pinned) {
+    uint64_t ops = bench->results[0].ops;
+    double mean = 0;
+    for (int b = 0; b < HIST_BUCKETS; b++) mean += bench->results[0].hist[b] * hist_upper(b);
+    printf("%-14s %5d %-8s %10.1f %10.0f %10.0f %10.0f %10.0f\n", name, 2,
+           pinned ? "pinned" : "free", ops ? mean / ops / ticks_per_ns : 0.0,
+           percentile(1, 0.5), percentile(1, 0.99), percentile(1, 0.999), percentile(1, 0.9999));
+}
+
+void print_header(const char* title) {
+    printf("\n%s\n%-14s %5s %-8s %10s %10s %10s %10s %10s\n", title, "primitive", "procs", "cpus",
+           "ns/op", "p50", "p99", "p99.9", "p99.99");
+}
+
+int main(int argc, char* argv[]) {
+    int millis = (argc > 1) ? atoi(argv[1]) : 200;
+    int max_procs = (argc > 2) ? atoi(argv[2]) : 8;
+    if (millis <= 0 || max_procs < 1 || max_procs > MAX_PROCS) {
+        printf("USAGE: %s [MILLISECONDS_PER_RUN] [MAX_PROCESSES (1-%d)]\n", argv[0], MAX_PROCS);
+        return -1;
+    }
+    n_cpus = (int)sysconf(_SC_NPROCESSORS_ONLN);
+
+    // Every primitive lives in the same shared segment
+    int fd;
+    bench = shared_create_anon(sizeof(Bench), SHARED_POPULATE, &fd);
+    sysv_mtx = mutex_create(IPC_PRIVATE, 1);
+    sysv_pingpong = sem_set_create(IPC_PRIVATE, 2, 0);
+    if (!bench || sysv_mtx == -1 || sysv_pingpong == -1) {
+        perror("setup");
+        return -1;
+    }
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutex_init(&bench->pmtx, &attr);
+    sem_init(&bench->sem, 1, 1);
+    fmutex_init(&bench->fmtx, 1);
+
+    ticks_per_ns = mutex_stats_calibrate();
+    printf("%d CPUs, %d ms per run, %.2f ticks/ns (latencies in ns, percentiles are bucket upper bounds)\n",
+           n_cpus, millis, ticks_per_ns);
+
+    print_header("Lock + unlock (1 process = uncontended)");
+    for (int pinned = 0; pinned <= 1; pinned++)
+        for (int n = 1; n <= max_procs; n *= 2)
+            for (int kind = 0; kind < N_LOCKS; kind++)
+                bench_lock(kind, n, pinned, millis);
+
+    print_header("Ping-pong round trip between 2 processes");
+    for (int pinned = 0; pinned <= 1; pinned++) {
+        for (int kind = 0; kind < N_PINGPONG; kind++) {
+            pingpong_kind = kind;
+            reset_pingpong();
+            run_workers(2, pinned, millis, pingpong_worker);
+            print_message_row(pingpong_names[kind], pinned);
+        }
+    }
+
+    print_header("One-way latency of a store seen by a spinning process");
+    for (int pinned = 0; pinned <= 1; pinned++) {
+        reset_pingpong();
+        run_workers(2, pinned, millis, oneway_worker);
+        print_message_row("spin store", pinned);
+    }
+
+    pthread_mutex_destroy(&bench->pmtx);
+    sem_destroy(&bench->sem);
+    mutex_remove(sysv_mtx);
+    sem_set_remove(sysv_pingpong);
+    shared_unmap(bench, sizeof(Bench));
+    close(fd);
+    return 0;
+}
@@ -6,7 +6,14 @@
 /* This is a wrapper library for the functions in <sys/sem.h> to simplify the */
 /* management of a mutex using semaphores. It provides functions for creating, */
 /* locking, unlocking, and removing a mutex semaphore.                         */
-/* Version: 2.0                                                               */
+/* Version 2.1 adds fmutex_t, a lock word for shared memory that only enters  */
+/* the kernel (futex) when contended. Compiling with -DMUTEX_FUTEX makes the  */
+/* mutex_*() functions use it instead of a semaphore, with the same API.      */
+/* Version 2.2 adds mutex_lock_timeout() and semaphore sets: counting         */
+/* semaphores, and batches of operations applied atomically by one semop().  */
+/* Version 2.3 adds optional contention statistics (-DMUTEX_STATS), kept in a */
+/* shared segment that the lockstat tool reads while the processes run.       */
+/* Version: 2.3                                                               */
 /*                                                                            */
 /* Copyright (c) 2024, Nico Fontani                                           */
 /* Creation Date: 13 Nov 2024                                                 */
@@ -17,15 +24,29 @@
 /* and maintain clear version tracking.                                       */
 /*                                                                            */
 /* Original Author: Nico Fontani                                              */
-/* Last Modified: 13 Nov 2024                                                 */
+/* Last Modified: 19 Oct 2026                                                 */
 /*                                                                            */
 /******************************************************************************/
 
 #ifndef __MUTEX_H
 #define __MUTEX_H
 
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/ipc.h>
+#include <sys/sem.h>
+#include <sys/shm.h>
+
+#include "./Futex.h"
+
 /*                      mutex.h
-        Wrapper library for the functions in <sys/sem.h> 
+        Wrapper library for the functions in <sys/sem.h>
                 (simplifies mutex management)
 */
 
@@ -33,21 +54,582 @@
 int mutex_create (key_t ipc_key, int starting_value);
 int mutex_find (key_t ipc_key);
 int mutex_lock(int sem_id);
+int mutex_lock_timeout(int sem_id, long timeout_ms);
 int mutex_unlock(int sem_id);
 int mutex_remove(int sem_id);
 
+/*                      fmutex_t
+        Futex-based mutex to be placed in a shared memory segment.
+        Free:       word == 0, taken with one compare-and-swap.
+        Taken:      word == owner thread id.
+        Contended:  FMUTEX_WAITERS is set and sleepers use futex_wait(),
+                    the owner calls futex_wake() when it unlocks.
+        Like SEM_UNDO, the lock is recovered if its owner dies: sleepers
+        wake up periodically and take over a lock whose owner is gone.
+*/
+
+#define FMUTEX_WAITERS    0x80000000u   /* Someone sleeps (or may sleep) on the word */
+#define FMUTEX_TID_MASK   0x3FFFFFFFu   /* Thread id of the owner */
+#define FMUTEX_SPIN_MAX   1000          /* Upper bound of the adaptive spin */
+#define FMUTEX_CHECK_NS   20000000L     /* Sleepers check the owner every 20 ms */
+
+typedef struct {
+  uint32_t word;   /* 0 if free, else owner tid, possibly | FMUTEX_WAITERS */
+  uint32_t spin;   /* Spins that were enough to get the lock lately */
+} fmutex_t;
+
+/* Prototypes */
+void fmutex_init(fmutex_t* mtx, int starting_value);
+int fmutex_lock(fmutex_t* mtx);
+int fmutex_lock_timeout(fmutex_t* mtx, long timeout_ms);
+int fmutex_trylock(fmutex_t* mtx);
+int fmutex_unlock(fmutex_t* mtx);
+int fmutex_owner_dead(uint32_t value);
+
+/* Thread id of the caller, cached because gettid() is a system call */
+__thread uint32_t fmutex_tid_cache;
+
+/* fork() copies the cache: the child must look its own id up again */
+void fmutex_tid_reset(void) {
+  fmutex_tid_cache = 0;
+}
+
+void fmutex_atfork_register(void) {
+  pthread_atfork(NULL, NULL, fmutex_tid_reset);
+}
+
+uint32_t fmutex_self(void) {
+  static pthread_once_t atfork_once = PTHREAD_ONCE_INIT;
+
+  if (fmutex_tid_cache == 0) {
+    pthread_once(&atfork_once, fmutex_atfork_register);
+    fmutex_tid_cache = (uint32_t)syscall(SYS_gettid) & FMUTEX_TID_MASK;
+  }
+  return fmutex_tid_cache;
+}
+
+/*                      Lock statistics
+        Compiled in only with -DMUTEX_STATS; otherwise the MUTEX_STATS_*()
+        macros expand to nothing and the locks are unchanged.
+        Every thread that takes a lock gets a slot in a SysV shared memory
+        segment (key MUTEX_STATS_KEY, created on first use) and counts there
+        its acquisitions, the contended ones, and log2 histograms (in TSC
+        cycles) of the time spent waiting and of the time the lock was held.
+        An uncontended lock reads the TSC once and so does the unlock; a
+        contended lock reads it once more, when the fast path has failed.
+        A process maps the segment once; each of its threads only claims a slot.
+        The hold time is kept per thread, not per lock: when a thread holds two
+        locks at once only the inner one is timed, the outer hold is lost.
+        lockstat.c reads the segment and prints the rates.
+*/
+
+#ifndef MUTEX_STATS_KEY
+#define MUTEX_STATS_KEY     0x4E464C53   /* "NFLS" */
+#endif
+#define MUTEX_STATS_SLOTS   256          /* Threads counted at the same time */
+#define MUTEX_STATS_BUCKETS 32           /* Bucket b: [2^b, 2^(b+1)) cycles */
+#define MUTEX_STATS_MAGIC   "NFLSTAT1"
+
+typedef struct {
+  uint32_t tid;                          /* 0 = free slot */
+  uint32_t pid;
+  uint64_t acquisitions;
+  uint64_t contended;
+  uint64_t wait_hist[MUTEX_STATS_BUCKETS];
+  uint64_t hold_hist[MUTEX_STATS_BUCKETS];
+} __attribute__((aligned(64))) mutex_stats_slot_t;
+
+typedef struct {
+  char               magic[8];
+  uint32_t           n_slots;
+  mutex_stats_slot_t slots[MUTEX_STATS_SLOTS];
+} mutex_stats_t;
+
+/* mutex_stats_now()
+   RETURNS: The time stamp counter (nanoseconds where there is none) */
+static inline uint64_t mutex_stats_now(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  return __builtin_ia32_rdtsc();
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+#endif
+}
+
+/* mutex_stats_bucket()
+   RETURNS: The histogram bucket of a duration in cycles */
+static inline int mutex_stats_bucket(uint64_t cycles) {
+  int b = 63 - __builtin_clzll(cycles | 1);
+  return b < MUTEX_STATS_BUCKETS ? b : MUTEX_STATS_BUCKETS - 1;
+}
+
+/* mutex_stats_seconds()
+   RETURNS: The monotonic clock, in seconds */
+static inline double mutex_stats_seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* mutex_stats_calibrate()
+   RETURNS: mutex_stats_now() ticks per nanosecond, measured against the
+            monotonic clock (takes 100 ms) */
+static inline double mutex_stats_calibrate(void) {
+  double t0 = mutex_stats_seconds();
+  uint64_t c0 = mutex_stats_now();
+  usleep(100000);
+  uint64_t c1 = mutex_stats_now();
+  double t1 = mutex_stats_seconds();
+  return (c1 - c0) / ((t1 - t0) * 1e9);
+}
+
+/* mutex_stats_percentile()
+   RECEIVES: A histogram of MUTEX_STATS_BUCKETS buckets, the fraction of the
+             samples (0.5 for the median) and the ticks per nanosecond
+   RETURNS: Upper bound (in ns) of the bucket holding that fraction, 0 if empty */
+static inline double mutex_stats_percentile(const uint64_t* hist, double fraction, double ticks_per_ns) {
+  uint64_t total = 0, seen = 0;
+  for (int b = 0; b < MUTEX_STATS_BUCKETS; b++) total += hist[b];
+  if (total == 0) return 0;
+  for (int b = 0; b < MUTEX_STATS_BUCKETS; b++) {
+    seen += hist[b];
+    if (seen >= fraction * total) return (double)(2ull << b) / ticks_per_ns;
+  }
+  return (double)(2ull << (MUTEX_STATS_BUCKETS - 1)) / ticks_per_ns;
+}
+
+#ifdef MUTEX_STATS
+
+__thread mutex_stats_slot_t* mutex_stats_mine;   /* Slot of this thread, NULL until the first lock */
+__thread uint64_t mutex_stats_hold_start;        /* When the last lock was taken */
+mutex_stats_slot_t mutex_stats_spare;            /* Used if the segment is full or missing */
+mutex_stats_t* mutex_stats_segment;              /* Mapped once per process, NULL if missing */
+
+/* fork() copies the slot pointer: the child must take its own slot
+   (the mapping itself is inherited) */
+void mutex_stats_reset(void) {
+  mutex_stats_mine = NULL;
+}
+
+/* Finds (or creates) the stats segment and maps it, once per process */
+void mutex_stats_map(void) {
+  pthread_atfork(NULL, NULL, mutex_stats_reset);
+
+  int created = 1;
+  int id = shmget(MUTEX_STATS_KEY, sizeof(mutex_stats_t), IPC_CREAT | IPC_EXCL | 0666);
+  if (id == -1 && errno == EEXIST) {
+    created = 0;
+    id = shmget(MUTEX_STATS_KEY, sizeof(mutex_stats_t), 0);
+  }
+  if (id == -1) return;
+  mutex_stats_t* stats = shmat(id, NULL, 0);
+  if (stats == (void*)-1) return;
+  if (created) {
+    stats->n_slots = MUTEX_STATS_SLOTS;
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(stats->magic, MUTEX_STATS_MAGIC, 8);
+  }
+  mutex_stats_segment = stats;
+}
+
+/* mutex_stats_attach()
+   Maps the stats segment (first call of the process) and takes a free slot,
+   or the slot of a thread that no longer exists.
+   RETURNS: The slot of the calling thread */
+mutex_stats_slot_t* mutex_stats_attach(void) {
+  static pthread_once_t map_once = PTHREAD_ONCE_INIT;
+  pthread_once(&map_once, mutex_stats_map);
+  mutex_stats_mine = &mutex_stats_spare;
+
+  mutex_stats_t* stats = mutex_stats_segment;
+  if (!stats) return mutex_stats_mine;
+
+  uint32_t self = fmutex_self();
+  for (int i = 0; i < MUTEX_STATS_SLOTS; i++) {
+    mutex_stats_slot_t* slot = &stats->slots[i];
+    uint32_t tid = __atomic_load_n(&slot->tid, __ATOMIC_RELAXED);
+    if (tid != 0 && !fmutex_owner_dead(tid)) continue;
+    if (!__atomic_compare_exchange_n(&slot->tid, &tid, self, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+      continue;
+    memset((char*)slot + sizeof(slot->tid), 0, sizeof(*slot) - sizeof(slot->tid));
+    slot->pid = (uint32_t)getpid();
+    mutex_stats_mine = slot;
+    break;
+  }
+  return mutex_stats_mine;
+}
+
+/* Counters are only written by their thread: plain relaxed stores, no lock prefix */
+#define MUTEX_STATS_INC(field) __atomic_store_n(&(field), (field) + 1, __ATOMIC_RELAXED)
+
+/* mutex_stats_acquired()
+   RECEIVES: When the caller started to wait, 0 if it got the lock at once */
+void mutex_stats_acquired(uint64_t wait_start) {
+  uint64_t now = mutex_stats_now();
+  mutex_stats_slot_t* slot = mutex_stats_mine ? mutex_stats_mine : mutex_stats_attach();
+
+  MUTEX_STATS_INC(slot->acquisitions);
+  if (wait_start) {
+    MUTEX_STATS_INC(slot->contended);
+    MUTEX_STATS_INC(slot->wait_hist[mutex_stats_bucket(now - wait_start)]);
+  } else {
+    MUTEX_STATS_INC(slot->wait_hist[0]);
+  }
+  mutex_stats_hold_start = now;
+}
+
+/* mutex_stats_released()
+   Called just before a lock is released */
+void mutex_stats_released(void) {
+  mutex_stats_slot_t* slot = mutex_stats_mine;
+  if (!slot || !mutex_stats_hold_start) return;
+  MUTEX_STATS_INC(slot->hold_hist[mutex_stats_bucket(mutex_stats_now() - mutex_stats_hold_start)]);
+  mutex_stats_hold_start = 0;
+}
+
+#define MUTEX_STATS_WAIT_START(var) uint64_t var = mutex_stats_now()
+#define MUTEX_STATS_ACQUIRED(start) mutex_stats_acquired(start)
+#define MUTEX_STATS_RELEASED()      mutex_stats_released()
+
+#else  /* MUTEX_STATS */
+
+#define MUTEX_STATS_WAIT_START(var)
+#define MUTEX_STATS_ACQUIRED(start) ((void)0)
+#define MUTEX_STATS_RELEASED()      ((void)0)
+
+#endif  /* MUTEX_STATS */
+
+/* fmutex_init()
+   RECEIVES: The lock word (in shared memory) and the initial value,
+             1 = unlocked, 0 = locked by the caller (as for mutex_create) */
+void fmutex_init(fmutex_t* mtx, int starting_value) {
+  mtx->spin = 0;
+  __atomic_store_n(&mtx->word, starting_value ? 0 : fmutex_self(), __ATOMIC_RELEASE);
+}
+
+/* fmutex_trylock()
+   RECEIVES: The lock word
+   RETURNS: 0 if the lock was taken, EBUSY otherwise */
+int fmutex_trylock(fmutex_t* mtx) {
+  uint32_t expected = 0;
+  if (!__atomic_compare_exchange_n(&mtx->word, &expected, fmutex_self(), 0,
+                                   __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+    return EBUSY;
+  MUTEX_STATS_ACQUIRED(0);
+  return 0;
+}
+
+/* fmutex_owner_dead()
+   RETURNS: 1 if the thread owning the lock word `value` no longer exists */
+int fmutex_owner_dead(uint32_t value) {
+  pid_t owner = (pid_t)(value & FMUTEX_TID_MASK);
+  return owner != 0 && kill(owner, 0) == -1 && errno == ESRCH;
+}
+
+/* fmutex_remaining()
+   RECEIVES: An absolute CLOCK_MONOTONIC deadline and where to store the time left
+   RETURNS: 0 if the deadline has passed */
+int fmutex_remaining(const struct timespec* deadline, struct timespec* left) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  left->tv_sec = deadline->tv_sec - now.tv_sec;
+  left->tv_nsec = deadline->tv_nsec - now.tv_nsec;
+  if (left->tv_nsec < 0) {
+    left->tv_sec--;
+    left->tv_nsec += 1000000000L;
+  }
+  return left->tv_sec > 0 || (left->tv_sec == 0 && left->tv_nsec > 0);
+}
+
+/* fmutex_lock_slow()
+   Contended path: spin for a while, then sleep on the futex.
+   deadline (CLOCK_MONOTONIC) is NULL to wait forever; ETIMEDOUT when it passes */
+int fmutex_lock_slow(fmutex_t* mtx, uint32_t self, const struct timespec* deadline) {
+  struct timespec check = { 0, FMUTEX_CHECK_NS };
+  uint32_t spin = __atomic_load_n(&mtx->spin, __ATOMIC_RELAXED);
+  uint32_t max_spin = (spin * 2 + 10 < FMUTEX_SPIN_MAX) ? spin * 2 + 10 : FMUTEX_SPIN_MAX;
+
+  /* Adaptive spin: the owner usually leaves soon, don't sleep right away */
+  for (uint32_t i = 0; i < max_spin; i++) {
+    cpu_relax();
+    uint32_t expected = 0;
+    if (__atomic_load_n(&mtx->word, __ATOMIC_RELAXED) == 0 &&
+        __atomic_compare_exchange_n(&mtx->word, &expected, self, 0,
+                                    __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+      /* Moving average of the spins that were needed */
+      __atomic_store_n(&mtx->spin, spin + ((int32_t)(i - spin) / 8), __ATOMIC_RELAXED);
+      return 0;
+    }
+  }
+  __atomic_store_n(&mtx->spin, spin + ((int32_t)(max_spin - spin) / 8), __ATOMIC_RELAXED);
+
+  /* Sleep. Once we have slept, we take the lock with the WAITERS flag set,
+     because other sleepers may still be waiting for a wake-up */
+  for (;;) {
+    uint32_t value = __atomic_load_n(&mtx->word, __ATOMIC_RELAXED);
+
+    if (value == 0) {
+      if (__atomic_compare_exchange_n(&mtx->word, &value, self | FMUTEX_WAITERS, 0,
+                                      __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        return 0;
+      continue;
+    }
+    if (!(value & FMUTEX_WAITERS)) {
+      if (!__atomic_compare_exchange_n(&mtx->word, &value, value | FMUTEX_WAITERS, 0,
+                                       __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        continue;
+      value |= FMUTEX_WAITERS;
+    }
+
+    struct timespec wait = check;
+    if (deadline) {
+      if (!fmutex_remaining(deadline, &wait)) return ETIMEDOUT;
+      if (wait.tv_sec > 0 || wait.tv_nsec > FMUTEX_CHECK_NS) wait = check;
+    }
+
+    if (futex_wait(&mtx->word, value, &wait) == -1 && errno == ETIMEDOUT &&
+        fmutex_owner_dead(value)) {
+      /* The owner died holding the lock: take it over (SEM_UNDO equivalent) */
+      if (__atomic_compare_exchange_n(&mtx->word, &value, self | FMUTEX_WAITERS, 0,
+                                      __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        return EOWNERDEAD;
+    }
+  }
+}
+
+/* fmutex_lock()
+   RECEIVES: The lock word
+   RETURNS: 0 on success, EOWNERDEAD if the lock was recovered from a dead
+            owner (the caller holds it, the protected data may be inconsistent) */
+int fmutex_lock(fmutex_t* mtx) {
+  uint32_t self = fmutex_self();
+  uint32_t expected = 0;
+
+  /* Fast path: free lock, no system call */
+  if (__atomic_compare_exchange_n(&mtx->word, &expected, self, 0,
+                                  __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+    MUTEX_STATS_ACQUIRED(0);
+    return 0;
+  }
+  MUTEX_STATS_WAIT_START(wait_start);
+  int ret = fmutex_lock_slow(mtx, self, NULL);
+  MUTEX_STATS_ACQUIRED(wait_start);
+  return ret;
+}
+
+/* fmutex_lock_timeout()
+   RECEIVES: The lock word and the longest time to wait, in milliseconds
+   RETURNS: 0 or EOWNERDEAD as fmutex_lock(), ETIMEDOUT if the lock was not taken in time */
+int fmutex_lock_timeout(fmutex_t* mtx, long timeout_ms) {
+  uint32_t self = fmutex_self();
+  uint32_t expected = 0;
+  struct timespec deadline;
+
+  if (__atomic_compare_exchange_n(&mtx->word, &expected, self, 0,
+                                  __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+    MUTEX_STATS_ACQUIRED(0);
+    return 0;
+  }
+  MUTEX_STATS_WAIT_START(wait_start);
+  clock_gettime(CLOCK_MONOTONIC, &deadline);
+  deadline.tv_sec += timeout_ms / 1000;
+  deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+  if (deadline.tv_nsec >= 1000000000L) {
+    deadline.tv_sec++;
+    deadline.tv_nsec -= 1000000000L;
+  }
+  int ret = fmutex_lock_slow(mtx, self, &deadline);
+  if (ret != ETIMEDOUT) MUTEX_STATS_ACQUIRED(wait_start);
+  return ret;
+}
+
+/* fmutex_unlock()
+   RECEIVES: The lock word
+   RETURNS: 0 on success */
+int fmutex_unlock(fmutex_t* mtx) {
+  uint32_t expected = fmutex_self();
+  MUTEX_STATS_RELEASED();
+
+  /* Fast path: nobody is sleeping, no system call */
+  if (__atomic_compare_exchange_n(&mtx->word, &expected, 0, 0,
+                                  __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+    return 0;
+
+  /* Sleepers (or an unlock from another process, allowed as for semaphores) */
+  __atomic_store_n(&mtx->word, 0, __ATOMIC_RELEASE);
+  futex_wake(&mtx->word, 1);
+  return 0;
+}
+
+/*                      Semaphore sets
+        A SysV set of n counting semaphores, whatever MUTEX_FUTEX says.
+        sem_ops_batch() hands several operations to one semop(): the kernel
+        applies all of them or none, so a process that needs several
+        resources takes them in one system call and without the deadlocks of
+        taking them one by one.
+        The acquire/release helpers use SEM_UNDO (the resources of a dead
+        process are given back): use them when the same process acquires
+        and releases. For signals between processes build the sembufs
+        without SEM_UNDO and call sem_ops_batch().
+*/
+
+#define SEM_SET_MAX_BATCH 32   /* Semaphores taken together by sem_set_acquire_many() */
+
+/* Prototypes */
+int sem_set_create(key_t ipc_key, int n_sems, int starting_value);
+int sem_set_find(key_t ipc_key);
+int sem_set_remove(int sem_id);
+int sem_set_value(int sem_id, int sem_num);
+int sem_ops_batch(int sem_id, struct sembuf* ops, size_t n_ops);
+int sem_ops_batch_timeout(int sem_id, struct sembuf* ops, size_t n_ops, long timeout_ms);
+int sem_set_acquire(int sem_id, int sem_num, int count);
+int sem_set_try_acquire(int sem_id, int sem_num, int count);
+int sem_set_release(int sem_id, int sem_num, int count);
+int sem_set_acquire_many(int sem_id, const unsigned short* sem_nums, int n);
+int sem_set_release_many(int sem_id, const unsigned short* sem_nums, int n);
+
+/* sem_set_create()
+   RECEIVES: The IPC key, the number of semaphores and the initial value of each
+   RETURNS: The ID of the semaphore set, -1 on failure */
+int sem_set_create(key_t ipc_key, int n_sems, int starting_value) {
+  if (n_sems <= 0 || n_sems > 0xFFFF || starting_value < 0 || starting_value > 0xFFFF) {
+    errno = EINVAL;
+    return -1;
+  }
+  int sem_id = semget(ipc_key, n_sems, IPC_CREAT | IPC_EXCL | 0666);
+  if (sem_id == -1)
+    return -1;
+
+  /* SETALL initializes the whole set with one semctl() */
+  unsigned short values[n_sems];
+  for (int i = 0; i < n_sems; i++) values[i] = (unsigned short)starting_value;
+  if (semctl(sem_id, 0, SETALL, values) == -1) {
+    semctl(sem_id, 0, IPC_RMID);
+    return -1;
+  }
+  return sem_id;
+}
+
+/* sem_set_find()
+   RECEIVES: The IPC key
+   RETURNS: The ID of the semaphore set, -1 on failure */
+int sem_set_find(key_t ipc_key) {
+  return semget(ipc_key, 0, 0);
+}
+
+/* sem_set_remove()
+   RECEIVES: The ID of the semaphore set
+   RETURNS: 0 on success */
+int sem_set_remove(int sem_id) {
+  return semctl(sem_id, 0, IPC_RMID);
+}
+
+/* sem_set_value()
+   RECEIVES: The ID of the semaphore set and the position of a semaphore
+   RETURNS: Its current value, -1 on failure */
+int sem_set_value(int sem_id, int sem_num) {
+  return semctl(sem_id, sem_num, GETVAL);
+}
+
+/* sem_ops_batch()
+   RECEIVES: The ID of the semaphore set and n_ops operations
+   RETURNS: 0 once all of them were applied together, -1 on failure */
+int sem_ops_batch(int sem_id, struct sembuf* ops, size_t n_ops) {
+  return semop(sem_id, ops, n_ops);
+}
+
+/* sem_ops_batch_timeout()
+   RECEIVES: As sem_ops_batch(), plus the longest time to wait in milliseconds
+   RETURNS: 0 on success, -1 with errno EAGAIN if the operations could not be applied in time */
+int sem_ops_batch_timeout(int sem_id, struct sembuf* ops, size_t n_ops, long timeout_ms) {
+  struct timespec timeout = { timeout_ms / 1000, (timeout_ms % 1000) * 1000000L };
+
+  /* semtimedop() is only declared with _GNU_SOURCE: call it directly */
+#ifdef SYS_semtimedop
+  return syscall(SYS_semtimedop, sem_id, ops, n_ops, &timeout);
+#else
+  (void)timeout;
+  errno = ENOSYS;
+  return -1;
+#endif
+}
+
+/* sem_set_acquire()
+   RECEIVES: The ID of the set, the position of a semaphore and how many units to take
+   RETURNS: 0 once they were taken */
+int sem_set_acquire(int sem_id, int sem_num, int count) {
+  struct sembuf op = { (unsigned short)sem_num, (short)-count, SEM_UNDO };
+  return semop(sem_id, &op, 1);
+}
+
+/* sem_set_try_acquire()
+   RETURNS: As sem_set_acquire(), but -1 with errno EAGAIN instead of waiting */
+int sem_set_try_acquire(int sem_id, int sem_num, int count) {
+  struct sembuf op = { (unsigned short)sem_num, (short)-count, SEM_UNDO | IPC_NOWAIT };
+  return semop(sem_id, &op, 1);
+}
+
+/* sem_set_release()
+   RECEIVES: The ID of the set, the position of a semaphore and how many units to give back
+   RETURNS: 0 on success */
+int sem_set_release(int sem_id, int sem_num, int count) {
+  struct sembuf op = { (unsigned short)sem_num, (short)count, SEM_UNDO };
+  return semop(sem_id, &op, 1);
+}
+
+/* sem_set_acquire_many()
+   RECEIVES: The ID of the set and the positions of n semaphores (at most SEM_SET_MAX_BATCH)
+   RETURNS: 0 once one unit of each was taken, all in the same semop() */
+int sem_set_acquire_many(int sem_id, const unsigned short* sem_nums, int n) {
+  struct sembuf ops[SEM_SET_MAX_BATCH];
+  if (n <= 0 || n > SEM_SET_MAX_BATCH) {
+    errno = EINVAL;
+    return -1;
+  }
+  for (int i = 0; i < n; i++) {
+    ops[i].sem_num = sem_nums[i];
+    ops[i].sem_op = -1;
+    ops[i].sem_flg = SEM_UNDO;
+  }
+  return semop(sem_id, ops, n);
+}
+
+/* sem_set_release_many()
+   RECEIVES: The ID of the set and the positions of n semaphores (at most SEM_SET_MAX_BATCH)
+   RETURNS: 0 once one unit of each was given back */
+int sem_set_release_many(int sem_id, const unsigned short* sem_nums, int n) {
+  struct sembuf ops[SEM_SET_MAX_BATCH];
+  if (n <= 0 || n > SEM_SET_MAX_BATCH) {
+    errno = EINVAL;
+    return -1;
+  }
+  for (int i = 0; i < n; i++) {
+    ops[i].sem_num = sem_nums[i];
+    ops[i].sem_op = +1;
+    ops[i].sem_flg = SEM_UNDO;
+  }
+  return semop(sem_id, ops, n);
+}
+
+#ifndef MUTEX_FUTEX
+
 /* Structs for the semop() system calls to modify the mutex value
    (semop() operates on a set of semaphores within an IPC structure) */
 struct sembuf sem_lock = {
                 0,              /* Position of the mutex in the semaphore set */
                 -1,             /* Decrements the mutex value by one */
                 SEM_UNDO };     /* The process will release the mutex even if there's an error */
-                
+
 struct sembuf sem_unlock = {
                 0,              /* Position of the mutex in the semaphore set */
                 +1,             /* Increments the mutex value by one */
                 SEM_UNDO };     /* The process will release the mutex even if there's an error */
 
+#ifdef MUTEX_STATS
+struct sembuf sem_trylock = { 0, -1, SEM_UNDO | IPC_NOWAIT };  /* To tell contended locks apart */
+#endif
+
 /* mutex_create()
    RECEIVES: The IPC key for the semaphore set and the initial value for the mutex
    RETURNS: A semaphore ID that identifies the mutex */
@@ -97,7 +679,36 @@ int mutex_lock(int sem_id) {
          sem_id     --> ID of the semaphore set
          &sem_lock  --> Operation to perform
          1          --> Number of operations in the second argument */
+#ifdef MUTEX_STATS
+    if (semop(sem_id, &sem_trylock, 1) == 0) {
+      MUTEX_STATS_ACQUIRED(0);
+      return 0;
+    }
+    if (errno != EAGAIN) return -1;
+    MUTEX_STATS_WAIT_START(wait_start);
+    int ret = semop(sem_id, &sem_lock, 1);
+    if (ret == 0) MUTEX_STATS_ACQUIRED(wait_start);
+    return ret;
+#else
     return semop(sem_id, &sem_lock, 1);
+#endif
+}
+
+/* mutex_lock_timeout()
+   RECEIVES: The semaphore set ID and the longest time to wait, in milliseconds
+   RETURNS: 0 on success, -1 with errno EAGAIN if the mutex was not taken in time */
+int mutex_lock_timeout(int sem_id, long timeout_ms) {
+#ifdef MUTEX_STATS
+  if (semop(sem_id, &sem_trylock, 1) == 0) {
+    MUTEX_STATS_ACQUIRED(0);
+    return 0;
+  }
+  if (errno != EAGAIN) return -1;
+#endif
+  MUTEX_STATS_WAIT_START(wait_start);
+  int ret = sem_ops_batch_timeout(sem_id, &sem_lock, 1, timeout_ms);
+  if (ret == 0) MUTEX_STATS_ACQUIRED(wait_start);
+  return ret;
 }
 
 /* mutex_unlock()
@@ -108,6 +719,7 @@ int mutex_unlock(int sem_id) {
          sem_id     --> ID of the semaphore set
          &sem_unlock  --> Operation to perform
          1          --> Number of operations in the second argument */
+    MUTEX_STATS_RELEASED();
     return semop(sem_id, &sem_unlock, 1);
  }
 
@@ -122,4 +734,110 @@ int mutex_remove(int sem_id) {
   return semctl(sem_id, 0, IPC_RMID);
 }
 
+#else  /* MUTEX_FUTEX */
+
+/* Drop-in version: the "semaphore ID" is the ID of a small shared memory
+   segment (same IPC key) holding an fmutex_t. Each process remembers where
+   it attached the segments it uses */
+
+#define MUTEX_FUTEX_MAX 16   /* Mutexes a process can use at the same time */
+
+struct {
+  int       id;
+  fmutex_t* mtx;
+} mutex_futex_table[MUTEX_FUTEX_MAX];
+int mutex_futex_count = 0;
+
+/* mutex_futex_attach()
+   RETURNS: id if the segment was attached and remembered, -1 otherwise */
+int mutex_futex_attach(int id) {
+  if (id == -1) return -1;
+  if (mutex_futex_count == MUTEX_FUTEX_MAX) {
+    errno = ENOSPC;
+    return -1;
+  }
+  void* addr = shmat(id, NULL, 0);
+  if (addr == (void*)-1) return -1;
+  mutex_futex_table[mutex_futex_count].id = id;
+  mutex_futex_table[mutex_futex_count].mtx = addr;
+  mutex_futex_count++;
+  return id;
+}
+
+/* mutex_futex_get()
+   RETURNS: The lock word behind an ID, NULL if it is unknown */
+fmutex_t* mutex_futex_get(int id) {
+  for (int i = 0; i < mutex_futex_count; i++)
+    if (mutex_futex_table[i].id == id) return mutex_futex_table[i].mtx;
+  errno = EINVAL;
+  return NULL;
+}
+
+/* mutex_create()
+   RECEIVES: The IPC key and the initial value for the mutex
+   RETURNS: An ID that identifies the mutex, -1 on failure */
+int mutex_create (key_t ipc_key, int starting_value) {
+  int id = mutex_futex_attach(shmget(ipc_key, sizeof(fmutex_t), IPC_CREAT | IPC_EXCL | 0666));
+  if (id != -1) fmutex_init(mutex_futex_get(id), starting_value);
+  return id;
+}
+
+/* mutex_find()
+   RECEIVES: The IPC key
+   RETURNS: The ID of the mutex, -1 on failure */
+int mutex_find (key_t ipc_key) {
+  int id = shmget(ipc_key, 0, 0);
+  if (id != -1 && mutex_futex_get(id)) return id;  /* Already attached */
+  return mutex_futex_attach(id);
+}
+
+/* mutex_lock()
+   RECEIVES: The mutex ID
+   RETURNS: 0 on success (also when recovered from a dead owner, as SEM_UNDO) */
+int mutex_lock(int sem_id) {
+  fmutex_t* mtx = mutex_futex_get(sem_id);
+  if (!mtx) return -1;
+  fmutex_lock(mtx);
+  return 0;
+}
+
+/* mutex_lock_timeout()
+   RECEIVES: The mutex ID and the longest time to wait, in milliseconds
+   RETURNS: 0 on success, -1 with errno EAGAIN if the mutex was not taken in time
+            (as semtimedop() does) */
+int mutex_lock_timeout(int sem_id, long timeout_ms) {
+  fmutex_t* mtx = mutex_futex_get(sem_id);
+  if (!mtx) return -1;
+  if (fmutex_lock_timeout(mtx, timeout_ms) == ETIMEDOUT) {
+    errno = EAGAIN;
+    return -1;
+  }
+  return 0;
+}
+
+/* mutex_unlock()
+   RECEIVES: The mutex ID
+   RETURNS: 0 on success */
+int mutex_unlock(int sem_id) {
+  fmutex_t* mtx = mutex_futex_get(sem_id);
+  if (!mtx) return -1;
+  return fmutex_unlock(mtx);
+}
+
+/* mutex_remove()
+   RECEIVES: The mutex ID
+   RETURNS: 0 on success */
+int mutex_remove(int sem_id) {
+  for (int i = 0; i < mutex_futex_count; i++) {
+    if (mutex_futex_table[i].id == sem_id) {
+      shmdt(mutex_futex_table[i].mtx);
+      mutex_futex_table[i] = mutex_futex_table[--mutex_futex_count];
+      break;
+    }
+  }
+  return shmctl(sem_id, IPC_RMID, NULL);
+}
+
+#endif  /* MUTEX_FUTEX */
+
 #endif  /* __MUTEX_H */
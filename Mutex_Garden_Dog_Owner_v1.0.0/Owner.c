@@ -7,6 +7,7 @@
 /* It accesses a shared memory segment representing a garden with plates.     */
 /* The owner cleans up the plates marked as 'POOP' and restores them to 'CLEAN'. */
 /* It uses a mutex to ensure that only one process can clean a plate at a time. */
+/* When the garden is clean it sleeps until the dog publishes a new poop.     */
 /*                                                                            */
 /* Copyright (c) 2024, Nico Fontani                                           */
 /* Creation Date: 13 Nov 2024                                                 */
@@ -17,7 +18,7 @@
 /* and maintain clear version tracking.                                       */
 /*                                                                            */
 /* Original Author: Nico Fontani                                              */
-/* Last Modified: 13 Nov 2024                                                 */
+/* Last Modified: 19 Oct 2026                                                 */
 /*                                                                            */
 /******************************************************************************/
 
@@ -25,57 +26,33 @@
 #include <stdlib.h>
 #include <unistd.h>
 
-#include "./mutex.h"
-#include "./shared.h"
-
-#define N_CICLES 100
-#define MTX_KEY 4242
-#define SHM_KEY 4243
-
-typedef enum {
-	CLEAN, POOP
-} Plate;
+#include "./Garden.h"
 
 int main(int argc, char* argv[]) {
-	// Check if the correct number of arguments is passed
-	if (argc != 2) {
-		printf("USAGE: %s #N_PLATES\n", argv[0]);
+	// Check the arguments: the number of plates, optionally the owner's index, and
+	// the garden's file descriptor and mutex ID when started by posix_spawn
+	if (argc != 2 && argc != 3 && argc != 5) {
+		printf("USAGE: %s #N_PLATES [#INDEX [#GARDEN_FD #MUTEX_ID]]\n", argv[0]);
 		return -1;
 	}
-
-	// Convert the number of plates from string to integer
-	int n_plates = atoi(argv[1]);
-
-	// Find the mutex and shared memory segment
-	int mtx_id = mutex_find(MTX_KEY);
-	int shm_id;
-	Plate* garden_path = shared_find(SHM_KEY, &shm_id);
-
-	// Initialize the owner's position
-	int position = 0;
-
-	// Owner's cleaning loop
-	printf("[%d] Owner is cleaning around...\n", getpid());
-	for (int i = 0; i < N_CICLES; i++) {
-		position++;  // Move to the next plate
-		if (position > n_plates) position = 0;  // Wrap around if we exceed the number of plates
-		
-		// Lock the mutex before modifying shared memory
-		mutex_lock(mtx_id);
-		
-		// If the plate is marked as 'POOP', clean it
-		if (*(garden_path + position) == POOP) {
-			*(garden_path + position) = CLEAN;
-		}
-		
-		// Unlock the mutex after modifying shared memory
-		mutex_unlock(mtx_id);
-
-		// Simulate the cleaning process with a small delay
-		usleep(100);
+	int index = (argc >= 3) ? atoi(argv[2]) : 0;
+
+	// Find the mutex and shared memory segment (or map the ones handed over)
+	int mtx_id, shm_id;
+	GardenHeader* garden;
+	if (argc == 5) {
+		mtx_id = atoi(argv[4]);
+		garden = garden_attach_fd(atoi(argv[3]), mtx_id);
+	} else {
+		mtx_id = mutex_find(MTX_KEY);
+		garden = shared_find(SHM_KEY, &shm_id);
+	}
+	if (!garden || garden == (void*)-1) {
+		printf("[%d] No garden to run in\n", getpid());
+		return -1;
 	}
 
-	// Print a message when the owner is done cleaning
-	printf("[%d] Owner can take a break, now.\n", getpid());
+	// The loop itself lives in Garden.h, shared with the threaded garden
+	garden_owner(garden, mtx_id, index);
 	return 0;
 }
@@ -0,0 +1,196 @@
+/******************************************************************************/
+/*                                                                            */
+/*                        Reader-Writer Lock and Seqlock                      */
+/*                                                                            */
+/* DESCRIPTION:                                                               */
+/* Two process-shared primitives for data read much more often than it is     */
+/* written. Both are plain structs meant to live inside a shared memory       */
+/* segment (see shared.h):                                                    */
+/*  - rwlock_t: many readers or one writer. Writers are preferred: once a     */
+/*    writer waits, new readers wait too. Sleeping is done with futex().      */
+/*  - seqlock_t: for small fixed-size records. Readers never write shared     */
+/*    memory: they copy the record and retry if a writer was active.          */
+/*                                                                            */
+/* Copyright (c) 2026, Nico Fontani                                           */
+/* Creation Date: 19 Oct 2026                                                 */
+/*                                                                            */
+/* This code was developed by Nico Fontani. Its use and modification are      */
+/* permitted, provided that any changes are documented, and the author        */
+/* and date are updated to recognize each developer's contribution            */
+/* and maintain clear version tracking.                                       */
+/*                                                                            */
+/* Original Author: Nico Fontani                                              */
+/* Last Modified: 19 Oct 2026                                                 */
+/*                                                                            */
+/******************************************************************************/
+
+#ifndef __RWLOCK_H
+#define __RWLOCK_H
+
+#include <limits.h>
+#include <string.h>
+
+#include "./Mutex.h"
+
+/*                      rwlock_t
+        state == number of readers, or RWLOCK_WRITER when a writer owns it.
+        Readers sleep on read_seq, writers on write_seq.
+*/
+
+#define RWLOCK_WRITER 0x80000000u
+
+typedef struct {
+  uint32_t state;            /* Readers inside, or RWLOCK_WRITER */
+  uint32_t writers_waiting;  /* Writers waiting: new readers must wait too */
+  uint32_t readers_waiting;  /* Readers sleeping on read_seq */
+  uint32_t read_seq;         /* Futex word for readers */
+  uint32_t write_seq;        /* Futex word for writers */
+} rwlock_t;
+
+/* Prototypes */
+void rwlock_init(rwlock_t* rw);
+int rwlock_read_lock(rwlock_t* rw);
+int rwlock_read_unlock(rwlock_t* rw);
+int rwlock_write_lock(rwlock_t* rw);
+int rwlock_write_unlock(rwlock_t* rw);
+
+/* rwlock_init()
+   RECEIVES: The lock, in shared memory */
+void rwlock_init(rwlock_t* rw) {
+  memset(rw, 0, sizeof(rwlock_t));
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+/* rwlock_read_lock()
+   RECEIVES: The lock
+   RETURNS: 0 once the caller can read */
+int rwlock_read_lock(rwlock_t* rw) {
+  for (;;) {
+    uint32_t state = __atomic_load_n(&rw->state, __ATOMIC_RELAXED);
+
+    /* Fast path: no writer inside or waiting, one atomic increment */
+    if (!(state & RWLOCK_WRITER) && __atomic_load_n(&rw->writers_waiting, __ATOMIC_RELAXED) == 0) {
+      if (__atomic_compare_exchange_n(&rw->state, &state, state + 1, 1,
+                                      __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        return 0;
+      continue;
+    }
+
+    /* Sleep until a writer leaves (check again after announcing ourselves) */
+    __atomic_fetch_add(&rw->readers_waiting, 1, __ATOMIC_SEQ_CST);
+    uint32_t seq = __atomic_load_n(&rw->read_seq, __ATOMIC_SEQ_CST);
+    state = __atomic_load_n(&rw->state, __ATOMIC_SEQ_CST);
+    if ((state & RWLOCK_WRITER) || __atomic_load_n(&rw->writers_waiting, __ATOMIC_SEQ_CST))
+      futex_wait(&rw->read_seq, seq, NULL);
+    __atomic_fetch_sub(&rw->readers_waiting, 1, __ATOMIC_RELAXED);
+  }
+}
+
+/* rwlock_read_unlock()
+   RECEIVES: The lock
+   RETURNS: 0 on success */
+int rwlock_read_unlock(rwlock_t* rw) {
+  uint32_t left = __atomic_sub_fetch(&rw->state, 1, __ATOMIC_RELEASE);
+
+  /* The last reader out hands the lock to a waiting writer */
+  if (left == 0 && __atomic_load_n(&rw->writers_waiting, __ATOMIC_SEQ_CST)) {
+    __atomic_fetch_add(&rw->write_seq, 1, __ATOMIC_SEQ_CST);
+    futex_wake(&rw->write_seq, 1);
+  }
+  return 0;
+}
+
+/* rwlock_write_lock()
+   RECEIVES: The lock
+   RETURNS: 0 once the caller is the only one inside */
+int rwlock_write_lock(rwlock_t* rw) {
+  uint32_t expected = 0;
+
+  /* Fast path: nobody inside */
+  if (__atomic_compare_exchange_n(&rw->state, &expected, RWLOCK_WRITER, 0,
+                                  __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+    return 0;
+
+  /* Block new readers, then wait for the ones inside to leave */
+  __atomic_fetch_add(&rw->writers_waiting, 1, __ATOMIC_SEQ_CST);
+  for (;;) {
+    uint32_t seq = __atomic_load_n(&rw->write_seq, __ATOMIC_SEQ_CST);
+    expected = 0;
+    if (__atomic_compare_exchange_n(&rw->state, &expected, RWLOCK_WRITER, 0,
+                                    __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+      break;
+    futex_wait(&rw->write_seq, seq, NULL);
+  }
+  __atomic_fetch_sub(&rw->writers_waiting, 1, __ATOMIC_SEQ_CST);
+  return 0;
+}
+
+/* rwlock_write_unlock()
+   RECEIVES: The lock
+   RETURNS: 0 on success */
+int rwlock_write_unlock(rwlock_t* rw) {
+  __atomic_store_n(&rw->state, 0, __ATOMIC_SEQ_CST);
+
+  /* Writers first; readers only when no writer is waiting any more */
+  if (__atomic_load_n(&rw->writers_waiting, __ATOMIC_SEQ_CST)) {
+    __atomic_fetch_add(&rw->write_seq, 1, __ATOMIC_SEQ_CST);
+    futex_wake(&rw->write_seq, 1);
+  } else if (__atomic_load_n(&rw->readers_waiting, __ATOMIC_SEQ_CST)) {
+    __atomic_fetch_add(&rw->read_seq, 1, __ATOMIC_SEQ_CST);
+    futex_wake(&rw->read_seq, INT_MAX);
+  }
+  return 0;
+}
+
+/*                      seqlock_t
+        seq is even when the record is stable, odd while a writer updates it.
+        Writers are serialized by an fmutex_t.
+*/
+
+typedef struct {
+  uint32_t seq;
+  fmutex_t writer;
+} seqlock_t;
+
+/* Prototypes */
+void seqlock_init(seqlock_t* sl);
+void seqlock_read(seqlock_t* sl, void* dest, const void* record, size_t len);
+void seqlock_write(seqlock_t* sl, void* record, const void* src, size_t len);
+
+/* seqlock_init()
+   RECEIVES: The seqlock, in shared memory */
+void seqlock_init(seqlock_t* sl) {
+  fmutex_init(&sl->writer, 1);
+  __atomic_store_n(&sl->seq, 0, __ATOMIC_RELEASE);
+}
+
+/* seqlock_read()
+   RECEIVES: The seqlock, where to copy the record, the shared record and its size.
+   The copy is retried until no writer was active while it was taken */
+void seqlock_read(seqlock_t* sl, void* dest, const void* record, size_t len) {
+  for (;;) {
+    uint32_t seq = __atomic_load_n(&sl->seq, __ATOMIC_ACQUIRE);
+    if (seq & 1) {
+      cpu_relax();
+      continue;
+    }
+    memcpy(dest, record, len);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&sl->seq, __ATOMIC_RELAXED) == seq)
+      return;
+  }
+}
+
+/* seqlock_write()
+   RECEIVES: The seqlock, the shared record, the new contents and their size */
+void seqlock_write(seqlock_t* sl, void* record, const void* src, size_t len) {
+  fmutex_lock(&sl->writer);
+  uint32_t seq = __atomic_load_n(&sl->seq, __ATOMIC_RELAXED);
+  __atomic_store_n(&sl->seq, seq + 1, __ATOMIC_RELAXED);  /* Odd: readers will retry */
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  memcpy(record, src, len);
+  __atomic_store_n(&sl->seq, seq + 2, __ATOMIC_RELEASE);  /* Even: stable again */
+  fmutex_unlock(&sl->writer);
+}
+
+#endif  /* __RWLOCK_H */
@@ -0,0 +1,192 @@
+/******************************************************************************/
+/*                                                                            */
+/*                          READER SCALING BENCHMARK                          */
+/*                                                                            */
+/* DESCRIPTION:                                                               */
+/* This program compares three ways of protecting a shared record read by     */
+/* many processes and updated by one writer: the exclusive mutex_lock()       */
+/* semaphore, the reader-writer lock and the seqlock of RWLock.h.             */
+/* For 1, 2, 4, ... 64 reader processes it prints the reads per second and    */
+/* checks that no reader ever saw a half-written record.                      */
+/*                                                                            */
+/* Copyright (c) 2026, Nico Fontani                                           */
+/* Creation Date: 19 Oct 2026                                                 */
+/*                                                                            */
+/* This code was developed by Nico Fontani. Its use and modification are      */
+/* permitted, provided that any changes are documented, and the author        */
+/* and date are updated to recognize each developer's contribution            */
+/* and maintain clear version tracking.                                       */
+/*                                                                            */
+/* Original Author: Nico Fontani                                              */
+/* Last Modified: 19 Oct 2026                                                 */
+/*                                                                            */
+/******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/wait.h>
+
+#include "./Mutex.h"
+#include "./RWLock.h"
+#include "./shared.h"
+
+#define MAX_READERS    64
+#define RECORD_WORDS   8        // The record: 8 words that must always be equal
+#define WRITE_PAUSE_US 100      // The writer updates the record every 100 us
+
+enum { USE_MUTEX, USE_RWLOCK, USE_SEQLOCK };
+const char* method_names[] = { "mutex_lock", "rwlock", "seqlock" };
+
+// Everything the processes share
+typedef struct {
+    rwlock_t  rw;
+    seqlock_t sl;
+    uint64_t  record[RECORD_WORDS];
+    int       stop;
+    uint64_t  reads[MAX_READERS];
+    uint64_t  torn[MAX_READERS];   // Reads that saw a half-written record
+} Bench;
+
+Bench* bench;
+int mtx_id;
+
+double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Read the record with the chosen method
+void read_record(int method, uint64_t* copy) {
+    switch (method) {
+    case USE_MUTEX:
+        mutex_lock(mtx_id);
+        memcpy(copy, bench->record, sizeof(bench->record));
+        mutex_unlock(mtx_id);
+        break;
+    case USE_RWLOCK:
+        rwlock_read_lock(&bench->rw);
+        memcpy(copy, bench->record, sizeof(bench->record));
+        rwlock_read_unlock(&bench->rw);
+        break;
+    case USE_SEQLOCK:
+        seqlock_read(&bench->sl, copy, bench->record, sizeof(bench->record));
+        break;
+    }
+}
+
+// Write a new value in every word of the record
+void write_record(int method, uint64_t value) {
+    uint64_t next[RECORD_WORDS];
+    for (int i = 0; i < RECORD_WORDS; i++) next[i] = value;
+
+    switch (method) {
+    case USE_MUTEX:
+        mutex_lock(mtx_id);
+        memcpy(bench->record, next, sizeof(next));
+        mutex_unlock(mtx_id);
+        break;
+    case USE_RWLOCK:
+        rwlock_write_lock(&bench->rw);
+        memcpy(bench->record, next, sizeof(next));
+        rwlock_write_unlock(&bench->rw);
+        break;
+    case USE_SEQLOCK:
+        seqlock_write(&bench->sl, bench->record, next, sizeof(next));
+        break;
+    }
+}
+
+void reader(int method, int id) {
+    uint64_t copy[RECORD_WORDS];
+    uint64_t reads = 0, torn = 0;
+
+    while (!__atomic_load_n(&bench->stop, __ATOMIC_RELAXED)) {
+        read_record(method, copy);
+        for (int i = 1; i < RECORD_WORDS; i++) {
+            if (copy[i] != copy[0]) {
+                torn++;
+                break;
+            }
+        }
+        reads++;
+    }
+    bench->reads[id] = reads;
+    bench->torn[id] = torn;
+}
+
+void writer(int method) {
+    uint64_t value = 0;
+    while (!__atomic_load_n(&bench->stop, __ATOMIC_RELAXED)) {
+        write_record(method, ++value);
+        usleep(WRITE_PAUSE_US);
+    }
+}
+
+// Run one configuration; returns reads per second, adds torn reads to *torn
+double run(int method, int n_readers, int millis, uint64_t* torn) {
+    memset(bench, 0, sizeof(Bench));
+    rwlock_init(&bench->rw);
+    seqlock_init(&bench->sl);
+
+    fflush(stdout);
+    double start = now_seconds();
+    for (int r = 0; r < n_readers; r++) {
+        if (!fork()) {
+            reader(method, r);
+            exit(0);
+        }
+    }
+    if (!fork()) {
+        writer(method);
+        exit(0);
+    }
+
+    usleep(millis * 1000);
+    __atomic_store_n(&bench->stop, 1, __ATOMIC_RELAXED);
+    while (wait(NULL) > 0)
+        ;
+    double elapsed = now_seconds() - start;
+
+    uint64_t total = 0;
+    for (int r = 0; r < n_readers; r++) {
+        total += bench->reads[r];
+        *torn += bench->torn[r];
+    }
+    return total / elapsed;
+}
+
+int main(int argc, char* argv[]) {
+    int millis = (argc > 1) ? atoi(argv[1]) : 500;
+    if (millis <= 0) {
+        printf("USAGE: %s [MILLISECONDS_PER_RUN]\n", argv[0]);
+        return -1;
+    }
+
+    int fd;
+    bench = shared_create_anon(sizeof(Bench), 0, &fd);
+    mtx_id = mutex_create(IPC_PRIVATE, 1);
+    if (!bench || mtx_id == -1) {
+        perror("setup");
+        return -1;
+    }
+
+    printf("1 writer every %d us, %d ms per run (reads/s)\n", WRITE_PAUSE_US, millis);
+    printf("%8s %14s %14s %14s\n", "readers", method_names[0], method_names[1], method_names[2]);
+    uint64_t torn = 0;
+    for (int n = 1; n <= MAX_READERS; n *= 2) {
+        printf("%8d", n);
+        for (int method = USE_MUTEX; method <= USE_SEQLOCK; method++)
+            printf(" %14.0f", run(method, n, millis, &torn));
+        printf("\n");
+    }
+    printf("Torn reads: %llu\n", (unsigned long long)torn);
+
+    mutex_remove(mtx_id);
+    shared_unmap(bench, sizeof(Bench));
+    close(fd);
+    return torn ? 1 : 0;
+}
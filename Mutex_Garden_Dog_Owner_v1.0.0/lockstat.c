@@ -0,0 +1,124 @@
+/******************************************************************************/
+/*                                                                            */
+/*                                  LOCKSTAT                                  */
+/*                                                                            */
+/* DESCRIPTION:                                                               */
+/* This program attaches to the lock statistics segment written by programs   */
+/* compiled with -DMUTEX_STATS (see Mutex.h) and prints, every interval, for  */
+/* each thread: locks taken per second, how many of them were contended and  */
+/* the median and 99th percentile of the wait and hold times.                */
+/* "lockstat -r" removes the segment.                                         */
+/*                                                                            */
+/* Copyright (c) 2026, Nico Fontani                                           */
+/* Creation Date: 19 Oct 2026                                                 */
+/*                                                                            */
+/* This code was developed by Nico Fontani. Its use and modification are      */
+/* permitted, provided that any changes are documented, and the author        */
+/* and date are updated to recognize each developer's contribution            */
+/* and maintain clear version tracking.                                       */
+/*                                                                            */
+/* Original Author: Nico Fontani                                              */
+/* Last Modified: 19 Oct 2026                                                 */
+/*                                                                            */
+/******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "./Mutex.h"
+
+// diff = now - before (before is taken as zero if the slot changed owner)
+void slot_diff(const mutex_stats_slot_t* now, const mutex_stats_slot_t* before, mutex_stats_slot_t* diff) {
+    int same = before->tid == now->tid && before->acquisitions <= now->acquisitions;
+    *diff = *now;
+    if (!same) return;
+    diff->acquisitions -= before->acquisitions;
+    diff->contended -= before->contended;
+    for (int b = 0; b < MUTEX_STATS_BUCKETS; b++) {
+        diff->wait_hist[b] -= before->wait_hist[b];
+        diff->hold_hist[b] -= before->hold_hist[b];
+    }
+}
+
+void print_row(const char* who, const mutex_stats_slot_t* d, double seconds, double ticks_per_ns) {
+    printf("%-14s %12.0f %12.0f %6.1f%% %10.0f %10.0f %10.0f %10.0f\n", who,
+           d->acquisitions / seconds, d->contended / seconds,
+           d->acquisitions ? 100.0 * d->contended / d->acquisitions : 0.0,
+           mutex_stats_percentile(d->wait_hist, 0.5, ticks_per_ns), mutex_stats_percentile(d->wait_hist, 0.99, ticks_per_ns),
+           mutex_stats_percentile(d->hold_hist, 0.5, ticks_per_ns), mutex_stats_percentile(d->hold_hist, 0.99, ticks_per_ns));
+}
+
+int main(int argc, char* argv[]) {
+    int id = shmget(MUTEX_STATS_KEY, 0, 0);
+
+    if (argc == 2 && !strcmp(argv[1], "-r")) {
+        if (id == -1 || shmctl(id, IPC_RMID, NULL) == -1) {
+            perror("lockstat -r");
+            return -1;
+        }
+        printf("Statistics segment removed\n");
+        return 0;
+    }
+
+    int interval_ms = (argc > 1) ? atoi(argv[1]) : 1000;
+    int count = (argc > 2) ? atoi(argv[2]) : 0;  // 0 = until interrupted
+    if (interval_ms <= 0 || count < 0) {
+        printf("USAGE: %s [INTERVAL_MS [COUNT]] | -r\n", argv[0]);
+        return -1;
+    }
+    if (id == -1) {
+        printf("No statistics segment: run a program compiled with -DMUTEX_STATS first\n");
+        return -1;
+    }
+    mutex_stats_t* stats = shmat(id, NULL, SHM_RDONLY);
+    if (stats == (void*)-1 || memcmp(stats->magic, MUTEX_STATS_MAGIC, 8)) {
+        printf("Invalid statistics segment\n");
+        return -1;
+    }
+
+    double ticks_per_ns = mutex_stats_calibrate();
+    static mutex_stats_slot_t before[MUTEX_STATS_SLOTS], now[MUTEX_STATS_SLOTS];
+    memcpy(before, stats->slots, sizeof(before));
+    double t_before = mutex_stats_seconds();
+
+    for (int round = 0; count == 0 || round < count; round++) {
+        usleep(interval_ms * 1000);
+        memcpy(now, stats->slots, sizeof(now));
+        double t_now = mutex_stats_seconds();
+        double seconds = t_now - t_before;
+
+        mutex_stats_slot_t total;
+        memset(&total, 0, sizeof(total));
+        printf("\n%-14s %12s %12s %7s %10s %10s %10s %10s\n", "pid/tid", "locks/s", "contended/s", "cont",
+               "wait p50", "wait p99", "hold p50", "hold p99");
+        for (int i = 0; i < MUTEX_STATS_SLOTS; i++) {
+            mutex_stats_slot_t d;
+            if (now[i].tid == 0) continue;
+            slot_diff(&now[i], &before[i], &d);
+            if (d.acquisitions == 0) continue;
+
+            char who[32];
+            snprintf(who, sizeof(who), "%u/%u", d.pid, d.tid);
+            print_row(who, &d, seconds, ticks_per_ns);
+
+            total.acquisitions += d.acquisitions;
+            total.contended += d.contended;
+            for (int b = 0; b < MUTEX_STATS_BUCKETS; b++) {
+                total.wait_hist[b] += d.wait_hist[b];
+                total.hold_hist[b] += d.hold_hist[b];
+            }
+        }
+        print_row("total", &total, seconds, ticks_per_ns);
+        printf("(times in ns, upper bound of the log2 bucket)\n");
+        fflush(stdout);
+
+        memcpy(before, now, sizeof(before));
+        t_before = t_now;
+    }
+
+    shmdt(stats);
+    return 0;
+}
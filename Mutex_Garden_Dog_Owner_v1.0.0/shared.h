@@ -4,8 +4,17 @@
  *                                                                            *
  *                                                                            *
  * This file provides an interface for managing shared memory areas.          *
- * It contains functions for creating, finding, and removing shared memory    *
- * segments using IPC (Inter-Process Communication) keys.                     *
+ * It contains functions for creating, finding, detaching and removing        *
+ * shared memory segments using IPC (Inter-Process Communication) keys.       *
+ *                                                                            *
+ * A second backend uses POSIX shared memory (shm_open/memfd_create + mmap):  *
+ * segments are looked up by name, sizes are size_t, and segments can use     *
+ * huge pages and be pre-faulted. Compiling with -DSHARED_POSIX makes         *
+ * shared_create()/shared_find()/shared_remove() use it, with the same API.   *
+ *                                                                            *
+ * On NUMA machines shared_mbind() places a range of any segment on chosen    *
+ * nodes (interleaved or bound), and shared_count_nodes() tells where the     *
+ * pages ended up; both use the raw system calls, no libnuma needed.          *
  *                                                                            *
  *                                                                            *
  * Copyright (c) 2024, Nico Fontani                                           *
@@ -17,21 +26,277 @@
  * and maintain clear version tracking.                                       *
  *                                                                            *
  * Original Author: Nico Fontani                                              *
- * Last Modified: 13 Nov 2024                                                 *
+ * Last Modified: 19 Oct 2026                                                 *
  *                                                                            *
  ******************************************************************************/
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <sys/types.h>
 #include <sys/ipc.h>
 #include <sys/shm.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/memfd.h>
 
 #ifndef __SHARED_H
 #define __SHARED_H
 
 /* Function prototypes */
 
+/* Options for the POSIX backend (combined in OR) */
+#define SHARED_HUGETLB  0x1   /* Explicit huge pages (anonymous segments only) */
+#define SHARED_THP      0x2   /* Ask for transparent huge pages */
+#define SHARED_POPULATE 0x4   /* Pre-fault the whole segment at creation/attach */
+
+#define SHARED_HUGE_PAGE (2UL * 1024 * 1024)   /* Size of a huge page */
+
+/* Memory policies for shared_mbind() (as in <linux/mempolicy.h>) */
+#define SHARED_MPOL_DEFAULT    0
+#define SHARED_MPOL_PREFERRED  1
+#define SHARED_MPOL_BIND       2
+#define SHARED_MPOL_INTERLEAVE 3
+#define SHARED_MPOL_MF_MOVE    (1 << 1)   /* Also move the pages already there */
+
+#define SHARED_MAX_NODES 64   /* Nodes in a mask (one unsigned long) */
+
+/* shared_map_fd()
+ * RECEIVES: A shared memory file descriptor, its size and the options.
+ * RETURNS: A pointer to the mapped area, or NULL on failure.
+ *          With SHARED_POPULATE every page is faulted in before returning,
+ *          so the first accesses do not cause page-fault storms.
+ */
+void* shared_map_fd(int fd, size_t len, int flags) {
+    int mmap_flags = MAP_SHARED;
+
+    /* MAP_POPULATE would fault the pages in before madvise() can ask for
+       huge pages: with SHARED_THP pre-fault afterwards instead */
+    if ((flags & SHARED_POPULATE) && !(flags & SHARED_THP))
+        mmap_flags |= MAP_POPULATE;
+
+    void* ret = mmap(NULL, len, PROT_READ | PROT_WRITE, mmap_flags, fd, 0);
+    if (ret == MAP_FAILED)
+        return NULL;
+
+    if (flags & SHARED_THP) {
+        madvise(ret, len, MADV_HUGEPAGE);   /* Only a hint: ignore failures */
+        if (flags & SHARED_POPULATE) {
+#ifdef MADV_POPULATE_WRITE
+            if (madvise(ret, len, MADV_POPULATE_WRITE) != 0)
+#endif
+            {
+                /* Older kernels: touch one byte per page */
+                long page = sysconf(_SC_PAGESIZE);
+                for (size_t i = 0; i < len; i += (size_t)page)
+                    __atomic_fetch_add((char*)ret + i, 0, __ATOMIC_RELAXED);
+            }
+        }
+    }
+    return ret;
+}
+
+/* shared_create_named()
+ * RECEIVES: A name ("/something"), the size of the area and the options.
+ * RETURNS: A pointer to the shared memory area, or NULL on failure
+ *          (also if a segment with that name already exists).
+ *          The file descriptor is returned via reference (it can be closed,
+ *          or passed to other processes that call shared_map_fd()).
+ */
+void* shared_create_named(const char* name, size_t len, int flags, int* fd) {
+    *fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0666);
+    if (*fd < 0)
+        return NULL;
+
+    void* ret = NULL;
+    if (ftruncate(*fd, (off_t)len) == 0)
+        ret = shared_map_fd(*fd, len, flags & ~SHARED_HUGETLB);  /* tmpfs: THP only */
+    if (!ret) {
+        close(*fd);
+        shm_unlink(name);
+        *fd = -1;
+    }
+    return ret;
+}
+
+/* shared_find_named()
+ * RECEIVES: The name of an existing segment and the options.
+ * RETURNS: A pointer to the shared memory area, or NULL on failure.
+ *          The size of the area and the file descriptor are returned
+ *          via reference.
+ */
+void* shared_find_named(const char* name, int flags, size_t* len, int* fd) {
+    struct stat st;
+
+    *fd = shm_open(name, O_RDWR, 0);
+    if (*fd < 0)
+        return NULL;
+
+    void* ret = NULL;
+    if (fstat(*fd, &st) == 0) {
+        *len = (size_t)st.st_size;
+        ret = shared_map_fd(*fd, *len, flags & ~SHARED_HUGETLB);
+    }
+    if (!ret) {
+        close(*fd);
+        *fd = -1;
+    }
+    return ret;
+}
+
+/* shared_create_anon()
+ * RECEIVES: The size of the area and the options.
+ * RETURNS: A pointer to an unnamed shared memory area, or NULL on failure.
+ *          The area is shared with children (fork) and with any process
+ *          that receives the file descriptor, returned via reference.
+ *          With SHARED_HUGETLB the size is rounded up to SHARED_HUGE_PAGE.
+ */
+void* shared_create_anon(size_t len, int flags, int* fd) {
+    unsigned int mfd_flags = 0;
+
+    if (flags & SHARED_HUGETLB) {
+        mfd_flags |= MFD_HUGETLB;
+        len = (len + SHARED_HUGE_PAGE - 1) & ~(SHARED_HUGE_PAGE - 1);
+    }
+    *fd = (int)syscall(SYS_memfd_create, "shared", mfd_flags);  /* No glibc wrapper without _GNU_SOURCE */
+    if (*fd < 0)
+        return NULL;
+
+    void* ret = NULL;
+    if (ftruncate(*fd, (off_t)len) == 0)
+        ret = shared_map_fd(*fd, len, flags & ~SHARED_HUGETLB);
+    if (!ret) {
+        close(*fd);
+        *fd = -1;
+    }
+    return ret;
+}
+
+/* shared_unmap()
+ * RECEIVES: An area returned by the POSIX backend and its size.
+ * RETURNS: 0 on success, 1 on failure.
+ */
+int shared_unmap(void* addr, size_t len) {
+    return (munmap(addr, len) == 0) ? 0 : 1;
+}
+
+/* shared_remove_named()
+ * RECEIVES: The name of a segment. Processes that mapped it keep using it.
+ * RETURNS: 0 on success, 1 on failure.
+ */
+int shared_remove_named(const char* name) {
+    return (shm_unlink(name) == 0) ? 0 : 1;
+}
+
+/* shared_numa_nodes()
+ * RETURNS: The number of NUMA nodes (1 on machines without NUMA).
+ */
+int shared_numa_nodes(void) {
+    char path[64];
+    int n = 0;
+
+    while (n < SHARED_MAX_NODES) {
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d", n);
+        if (access(path, F_OK) != 0)
+            break;
+        n++;
+    }
+    return n ? n : 1;
+}
+
+/* shared_node_cpu()
+ * RECEIVES: A node and a number k.
+ * RETURNS: The k-th CPU of the node (counting round the node's CPUs),
+ *          -1 if the node has none or cannot be read.
+ */
+int shared_node_cpu(int node, int k) {
+    char path[64], list[1024];
+    int cpus[1024], n = 0;
+
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+    FILE* f = fopen(path, "r");
+    if (!f)
+        return -1;
+    if (!fgets(list, sizeof(list), f))
+        list[0] = '\0';
+    fclose(f);
+
+    /* "0-3,8-11" */
+    for (char* p = list; *p && n < 1024;) {
+        char* end;
+        long first = strtol(p, &end, 10), last;
+        if (end == p)
+            break;
+        last = first;
+        if (*end == '-')
+            last = strtol(end + 1, &end, 10);
+        for (long c = first; c <= last && n < 1024; c++)
+            cpus[n++] = (int)c;
+        p = (*end == ',') ? end + 1 : end;
+    }
+    return n ? cpus[k % n] : -1;
+}
+
+/* shared_current_node()
+ * RETURNS: The node of the CPU the caller is running on.
+ */
+int shared_current_node(void) {
+    unsigned cpu = 0, node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, NULL) != 0)
+        return 0;
+    return (int)node;
+}
+
+/* shared_mbind()
+ * RECEIVES: A range of a mapped segment, a policy (SHARED_MPOL_*), the mask of
+ *           the nodes to use and the flags (0, or SHARED_MPOL_MF_MOVE).
+ *           The range is widened to whole pages.
+ * RETURNS: 0 on success, -1 on failure (errno as mbind(2)).
+ */
+int shared_mbind(void* addr, size_t len, int policy, unsigned long nodemask, int flags) {
+    uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t start = (uintptr_t)addr & ~(page - 1);
+    uintptr_t end = ((uintptr_t)addr + len + page - 1) & ~(page - 1);
+
+    return (int)syscall(SYS_mbind, start, end - start, policy,
+                        policy == SHARED_MPOL_DEFAULT ? NULL : &nodemask, SHARED_MAX_NODES + 1, flags);
+}
+
+/* shared_count_nodes()
+ * RECEIVES: A range of a mapped segment and an array of SHARED_MAX_NODES counters.
+ * RETURNS: The number of pages of the range not in memory yet; the pages on
+ *          each node are added to the counters.
+ */
+long shared_count_nodes(void* addr, size_t len, long* pages_on_node) {
+    uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t start = (uintptr_t)addr & ~(page - 1);
+    uintptr_t end = (uintptr_t)addr + len;
+    void* pages[256];
+    int status[256];
+    long missing = 0;
+
+    while (start < end) {
+        int n = 0;
+        for (; n < 256 && start < end; n++, start += page)
+            pages[n] = (void*)start;
+        if (syscall(SYS_move_pages, 0, n, pages, NULL, status, 0) != 0)
+            return missing + n;
+        for (int i = 0; i < n; i++) {
+            if (status[i] >= 0 && status[i] < SHARED_MAX_NODES)
+                pages_on_node[status[i]]++;
+            else
+                missing++;
+        }
+    }
+    return missing;
+}
+
+#ifndef SHARED_POSIX
+
 /* shared_create()
  * RECEIVES: IPC key and the size of the memory area to create.
  * RETURNS: A pointer to the shared memory area, or NULL on failure.
@@ -64,6 +329,16 @@ void* shared_find(int ipc_key, int* shm_id) {
     return ret;
 }
 
+/* shared_detach()
+ * RECEIVES: An area returned by shared_create() or shared_find(), and its
+ *           shared memory ID. The segment itself stays.
+ * RETURNS: 0 on success, 1 on failure.
+ */
+int shared_detach(void* addr, int shm_id) {
+    (void)shm_id;
+    return (shmdt(addr) == 0) ? 0 : 1;
+}
+
 /* shared_remove()
  * RECEIVES: The shared memory ID.
  * RETURNS: 0 on success, 1 on failure.
@@ -75,4 +350,83 @@ int shared_remove(int shm_id) {
     return ((ret != -1) ? 0 : 1);
 }
 
+#else /* SHARED_POSIX */
+
+/* The classic API on top of the POSIX backend: the IPC key becomes the
+ * segment name "/shared_<key>" and is also used as the shared memory ID.
+ */
+
+void shared_key_name(int ipc_key, char* name, size_t len) {
+    snprintf(name, len, "/shared_%d", ipc_key);
+}
+
+/* shared_create()
+ * RECEIVES: IPC key and the size of the memory area to create.
+ * RETURNS: A pointer to the shared memory area, or NULL on failure.
+ *          The shared memory ID is returned via reference.
+ */
+void* shared_create(int ipc_key, int len, int* shm_id) {
+    char name[32];
+    int fd;
+
+    shared_key_name(ipc_key, name, sizeof(name));
+    void* ret = shared_create_named(name, (size_t)len, 0, &fd);
+    if (!ret)
+        return NULL;
+    close(fd);  /* The mapping stays valid */
+    *shm_id = ipc_key;
+    return ret;
+}
+
+/* shared_find()
+ * RECEIVES: IPC key.
+ * RETURNS: A pointer to the shared memory area, or NULL on failure.
+ *          The shared memory ID is returned via reference.
+ */
+void* shared_find(int ipc_key, int* shm_id) {
+    char name[32];
+    size_t len;
+    int fd;
+
+    shared_key_name(ipc_key, name, sizeof(name));
+    void* ret = shared_find_named(name, 0, &len, &fd);
+    if (!ret)
+        return NULL;
+    close(fd);
+    *shm_id = ipc_key;
+    return ret;
+}
+
+/* shared_detach()
+ * RECEIVES: An area returned by shared_create() or shared_find(), and its
+ *           shared memory ID. The segment itself stays.
+ * RETURNS: 0 on success, 1 on failure.
+ */
+int shared_detach(void* addr, int shm_id) {
+    char name[32];
+    struct stat st;
+
+    /* The mapping is as long as the segment: ask the segment */
+    shared_key_name(shm_id, name, sizeof(name));
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0)
+        return 1;
+    int ret = fstat(fd, &st);
+    close(fd);
+    return (ret == 0 && munmap(addr, (size_t)st.st_size) == 0) ? 0 : 1;
+}
+
+/* shared_remove()
+ * RECEIVES: The shared memory ID.
+ * RETURNS: 0 on success, 1 on failure.
+ */
+int shared_remove(int shm_id) {
+    char name[32];
+
+    shared_key_name(shm_id, name, sizeof(name));
+    return shared_remove_named(name);
+}
+
+#endif /* SHARED_POSIX */
+
 #endif /* __SHARED_H */
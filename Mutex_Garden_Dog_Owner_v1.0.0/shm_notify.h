@@ -0,0 +1,129 @@
+/******************************************************************************
+ *                                                                            *
+ *                                SHM_NOTIFY.H                                *
+ *                                                                            *
+ *                                                                            *
+ * This file provides change notification for shared memory: a sequence      *
+ * counter (shm_notify_t) placed next to the data it guards. A producer      *
+ * calls shm_notify_publish() after changing the data; a consumer remembers  *
+ * the last sequence it saw and sleeps in shm_wait_change() until it moves.  *
+ * Updates coalesce: publishing only makes a system call when a consumer is  *
+ * asleep, and a consumer that wakes up sees every update made meanwhile.    *
+ *                                                                            *
+ *                                                                            *
+ * Copyright (c) 2026, Nico Fontani                                           *
+ * Creation Date: 19 Oct 2026                                                 *
+ *                                                                            *
+ * This code was developed by Nico Fontani. Its use and modification are      *
+ * permitted, provided that any changes are documented, and the author        *
+ * and date are updated to recognize each developer's contribution            *
+ * and maintain clear version tracking.                                       *
+ *                                                                            *
+ * Original Author: Nico Fontani                                              *
+ * Last Modified: 19 Oct 2026                                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+#include <stdint.h>
+#include <limits.h>
+#include <errno.h>
+#include <time.h>
+
+#include "Futex.h"
+
+#ifndef __SHM_NOTIFY_H
+#define __SHM_NOTIFY_H
+
+#define SHM_NOTIFY_SPIN 100    /* Checks before sleeping on the futex */
+
+/* Lives in shared memory; all zero is a valid initial state */
+typedef struct {
+    uint32_t seq;              /* Incremented by every publish */
+    uint32_t waiters;          /* Consumers asleep (or about to sleep) */
+} shm_notify_t;
+
+/* shm_notify_init()
+ * RECEIVES: The counter, in shared memory.
+ */
+void shm_notify_init(shm_notify_t* n) {
+    __atomic_store_n(&n->waiters, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&n->seq, 0, __ATOMIC_RELEASE);
+}
+
+/* shm_notify_read()
+ * RECEIVES: The counter.
+ * RETURNS: The current sequence: read it BEFORE reading the data.
+ */
+uint32_t shm_notify_read(shm_notify_t* n) {
+    return __atomic_load_n(&n->seq, __ATOMIC_ACQUIRE);
+}
+
+/* shm_notify_publish()
+ * RECEIVES: The counter. Call it after the data has been changed.
+ */
+void shm_notify_publish(shm_notify_t* n) {
+    __atomic_fetch_add(&n->seq, 1, __ATOMIC_SEQ_CST);
+
+    /* Nobody asleep: no system call, the change is picked up at the next check */
+    if (__atomic_load_n(&n->waiters, __ATOMIC_SEQ_CST))
+        futex_wake(&n->seq, INT_MAX);
+}
+
+/* shm_wait_change()
+ * RECEIVES: The counter, the last sequence the caller saw and the longest
+ *           time to wait in milliseconds (negative waits forever).
+ * RETURNS: The current sequence; it equals `seen` only if the time ran out.
+ */
+uint32_t shm_wait_change(shm_notify_t* n, uint32_t seen, long timeout_ms) {
+    uint32_t seq;
+    struct timespec deadline, left;
+
+    /* The producer is often just about to publish: look a few times first */
+    for (int i = 0; i < SHM_NOTIFY_SPIN; i++) {
+        seq = __atomic_load_n(&n->seq, __ATOMIC_ACQUIRE);
+        if (seq != seen)
+            return seq;
+        cpu_relax();
+    }
+
+    if (timeout_ms >= 0) {
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+    }
+
+    __atomic_fetch_add(&n->waiters, 1, __ATOMIC_SEQ_CST);
+    for (;;) {
+        seq = __atomic_load_n(&n->seq, __ATOMIC_SEQ_CST);
+        if (seq != seen)
+            break;
+
+        const struct timespec* timeout = NULL;
+        if (timeout_ms >= 0) {
+            struct timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            left.tv_sec = deadline.tv_sec - now.tv_sec;
+            left.tv_nsec = deadline.tv_nsec - now.tv_nsec;
+            if (left.tv_nsec < 0) {
+                left.tv_sec--;
+                left.tv_nsec += 1000000000L;
+            }
+            if (left.tv_sec < 0)
+                break;
+            timeout = &left;
+        }
+        /* Sleeps only if seq still equals seen: a publish can't be missed */
+        if (futex_wait(&n->seq, seen, timeout) == -1 && errno == ETIMEDOUT) {
+            seq = __atomic_load_n(&n->seq, __ATOMIC_ACQUIRE);
+            break;
+        }
+    }
+    __atomic_fetch_sub(&n->waiters, 1, __ATOMIC_RELAXED);
+    return seq;
+}
+
+#endif /* __SHM_NOTIFY_H */
@@ -1,172 +1,621 @@
-/******************************************************************************
-/*                                                                            */
-/*                          DOG AND OWNER IN GARDEN                           */
-/*                                                                            */
-/* DESCRIPTION:                                                               */
-/* This program simulates the interaction between a dog and its owner         */
-/* in a garden using threads and semaphores. The dog randomly dirties         */
-/* clean spaces, while the owner cleans up the dirty spaces.                  */
-/* The program uses POSIX threads and semaphores to synchronize the           */
-/* activities and prevent race conditions.                                    */
-/*                                                                            */
-/*                                                                            */
-/* Copyright (c) 2025, Nico Fontani                                           */
-/* Creation Date: 01 Apr 2025                                                 */
-/*                                                                            */
-/* This code was developed by Nico Fontani. Its use and modification are      */
-/* permitted, provided that any changes are documented, and the author        */
-/* and date are updated to recognize each developer's contribution            */
-/* and maintain clear version tracking.                                       */
-/*                                                                            */
-/* Original Author: Nico Fontani                                              */
-/* Last Modified: 01 Apr 2025                                                 */
-/*                                                                            */
-/******************************************************************************/
-
-
-#include <stdio.h>
-#include <stdlib.h>
-#include <pthread.h>
-#include <semaphore.h>
-#include <unistd.h>
-#include <time.h>
-
-// Garden structure definition
-#define GARDEN_SIZE 10
-int garden[GARDEN_SIZE];  // 0 = clean, 1 = dirty
-
-// Semaphores
-sem_t sem_dirty_spaces;    // Counts how many spaces are dirty (for the owner)
-sem_t sem_clean_spaces;    // Counts how many spaces are clean (for the dog)
-sem_t sem_mutex;           // Protects access to the garden
-
-// Thread functions
-void* dog_thread(void* arg);
-void* owner_thread(void* arg);
-
-// Function to print the garden state
-void print_garden() {
-    printf("Garden state: ");
-    for (int i = 0; i < GARDEN_SIZE; i++) {
-        if (garden[i] == 0) {
-            printf("🌱 ");  // Clean space
-        } else {
-            printf("💩 ");  // Dirty space
-        }
-    }
-    printf("\n");
-}
-
-// Dog thread
-void* dog_thread(void* arg) {
-    int dirt_count = *((int*)arg);
-    
-    for (int i = 0; i < dirt_count; i++) {
-        // Wait for at least one clean space
-        sem_wait(&sem_clean_spaces);
-        
-        // Wait a bit before making a mess
-        int wait_time = (rand() % 3) + 1;
-        printf("The dog is looking for a place to make a mess... (waiting: %d seconds)\n", wait_time);
-        sleep(wait_time);
-        
-        // Protect access to the garden
-        sem_wait(&sem_mutex);
-        
-        // Find a clean space and make it dirty
-        int position;
-        do {
-            position = rand() % GARDEN_SIZE;
-        } while (garden[position] != 0);
-        
-        garden[position] = 1;  // Dirty the space
-        printf("The dog has made a mess at position %d!\n", position);
-        print_garden();
-        
-        // Release the mutex
-        sem_post(&sem_mutex);
-        
-        // Signal that there's a new dirty space
-        sem_post(&sem_dirty_spaces);
-    }
-    
-    printf("The dog has finished making messes and goes to sleep.\n");
-    return NULL;
-}
-
-// Owner thread
-void* owner_thread(void* arg) {
-    int cleaning_count = *((int*)arg);
-    
-    for (int i = 0; i < cleaning_count; i++) {
-        // Wait for at least one dirty space
-        sem_wait(&sem_dirty_spaces);
-        
-        // Wait a bit before cleaning
-        int wait_time = (rand() % 2) + 1;
-        printf("The owner is looking for a mess to clean... (waiting: %d seconds)\n", wait_time);
-        sleep(wait_time);
-        
-        // Protect access to the garden
-        sem_wait(&sem_mutex);
-        
-        // Find a dirty space and clean it
-        int position;
-        do {
-            position = rand() % GARDEN_SIZE;
-        } while (garden[position] != 1);
-        
-        garden[position] = 0;  // Clean the space
-        printf("The owner has cleaned position %d!\n", position);
-        print_garden();
-        
-        // Release the mutex
-        sem_post(&sem_mutex);
-        
-        // Signal that there's a new clean space
-        sem_post(&sem_clean_spaces);
-    }
-    
-    printf("The owner has finished cleaning and goes to rest.\n");
-    return NULL;
-}
-
-int main() {
-    pthread_t dog, owner;
-    
-    // Initialize the random number generator
-    srand(time(NULL));
-    
-    // Initialize the garden (all clean at the beginning)
-    for (int i = 0; i < GARDEN_SIZE; i++) {
-        garden[i] = 0;
-    }
-    
-    printf("Initial garden state:\n");
-    print_garden();
-    
-    // Initialize semaphores
-    sem_init(&sem_dirty_spaces, 0, 0);       // No dirty spaces at the beginning
-    sem_init(&sem_clean_spaces, 0, GARDEN_SIZE); // All spaces are clean at the beginning
-    sem_init(&sem_mutex, 0, 1);              // Mutex initially unlocked
-    
-    // How many actions to perform
-    int dirt_count = 8;
-    int cleaning_count = 8;
-    
-    // Create threads
-    pthread_create(&dog, NULL, dog_thread, &dirt_count);
-    pthread_create(&owner, NULL, owner_thread, &cleaning_count);
-    
-    // Wait for threads to complete
-    pthread_join(dog, NULL);
-    pthread_join(owner, NULL);
-    
-    // Destroy semaphores
-    sem_destroy(&sem_dirty_spaces);
-    sem_destroy(&sem_clean_spaces);
-    sem_destroy(&sem_mutex);
-    
-    printf("Simulation completed!\n");
-    return 0;
-}
\ No newline at end of file
+/******************************************************************************
+/*                                                                            */
+/*                          DOG AND OWNER IN GARDEN                           */
+/*                                                                            */
+/* DESCRIPTION:                                                               */
+/* This program simulates the interaction between dogs and their owners       */
+/* in a garden using threads. The dogs randomly dirty clean spaces, while     */
+/* the owners clean up the dirty spaces.                                      */
+/* Clean positions are kept in an index set, so a dog picks a random clean    */
+/* space in constant time, however full the garden is. Dirty positions go     */
+/* from the dogs to the owners through a queue bounded by the garden size.    */
+/* Both are handed over in batches: one lock, and at most one wakeup, moves   */
+/* up to BATCH positions. A thread that finds nothing spins for a while       */
+/* (longer when spinning paid off last time) before it sleeps on a            */
+/* condition variable.                                                        */
+/* Usage: pthread_semaphores [-b] [GARDEN_SIZE [ACTIONS [DOGS [OWNERS         */
+/*        [BATCH]]]]]                                                         */
+/* (-b: no waits and no drawing; prints items/s and wakeups per item)         */
+/* All the output comes from a renderer thread: the dogs and the owners only  */
+/* push events on a lock-free queue, and the renderer writes every batch of   */
+/* events as one frame, with one write(), outside the critical section.       */
+/*                                                                            */
+/*                                                                            */
+/*                                                                            */
+/* Copyright (c) 2025, Nico Fontani                                           */
+/* Creation Date: 01 Apr 2025                                                 */
+/*                                                                            */
+/* This code was developed by Nico Fontani. Its use and modification are      */
+/* permitted, provided that any changes are documented, and the author        */
+/* and date are updated to recognize each developer's contribution            */
+/* and maintain clear version tracking.                                       */
+/*                                                                            */
+/* Original Author: Nico Fontani                                              */
+/* Last Modified: 19 Oct 2026                                                 */
+/*                                                                            */
+/******************************************************************************/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <unistd.h>
+#include <time.h>
+#include <stdint.h>
+#include <string.h>
+#include <sched.h>
+#include <stdatomic.h>
+
+// Garden structure definition (size chosen at run time)
+#define DEFAULT_GARDEN_SIZE 10
+#define PRINT_MAX 50       // Larger gardens are printed as counts only
+int garden_size = DEFAULT_GARDEN_SIZE;
+int* garden;               // 0 = clean, 1 = dirty
+int bench = 0;             // -b: no waits, no events, only the throughput at the end
+int n_dogs = 1, n_owners = 1;
+int batch = 1;             // Positions moved per handoff, at most
+
+// Set of positions with swap-remove: add, remove and random pick in O(1)
+typedef struct {
+    int* items;            // The positions in the set, in no order
+    int count;
+} IndexSet;
+
+// Dirty positions, oldest first. It never holds more than the garden, so a dog
+// never waits for room: the clean set is what holds the dogs back.
+typedef struct {
+    int* items;            // garden_size entries
+    int head, tail;        // Next to take, next to fill
+} PositionQueue;
+
+// Where threads meet: a lock, and a condition variable for the ones waiting
+// for something to take
+#define SPIN_MIN 16
+#define SPIN_MAX 4096
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    int sleeping;          // Threads waiting on not_empty
+    int signaled;          // Of those, already signaled but not yet running
+    atomic_int available;  // Positions to take (read without the lock while spinning)
+    atomic_int spin;       // Checks before sleeping: doubled or halved after each wait
+} Gate;
+
+#if defined(__x86_64__) || defined(__i386__)
+#define cpu_relax() __builtin_ia32_pause()
+#elif defined(__aarch64__)
+#define cpu_relax() __asm__ __volatile__("yield")
+#else
+#define cpu_relax() ((void)0)
+#endif
+
+IndexSet clean_set;        // Clean spaces (for the dogs), behind clean_gate
+int* slot;                 // slot[p] = where position p is in clean_set
+PositionQueue dirty_queue; // Dirty spaces (for the owners), behind dirty_gate
+Gate clean_gate, dirty_gate;
+
+// What every thread counts, summed by main at the end
+typedef struct {
+    long items;            // Positions handed over
+    long handoffs;         // Times the lock was taken to put or take them
+    long sleeps;           // Times the thread found nothing, even after spinning
+    long wakeups;          // Returns from pthread_cond_wait()
+    long signals;          // pthread_cond_signal() calls
+    long spins;            // Times spinning found something: a sleep saved
+} Counters;
+
+typedef struct {
+    int index;             // Dog or owner number
+    int count;             // Positions to dirty or to clean
+    Counters counters;
+} Worker;
+
+// What the dogs and the owners tell the renderer
+typedef enum {
+    DOG_LOOKING, DOG_MESS, DOG_DONE, OWNER_LOOKING, OWNER_CLEAN, OWNER_DONE, RENDER_QUIT
+} EventType;
+
+typedef struct {
+    EventType type;
+    int who;               // Dog or owner number
+    int value;             // Position, or waiting time for the *_LOOKING events
+} Event;
+
+// Lock-free event queue: many producers, one consumer (the renderer).
+// Every slot has a sequence number telling whether it is free or full.
+#define EVENT_QUEUE_SIZE 1024  // Power of two
+typedef struct {
+    atomic_ulong seq;
+    Event event;
+} EventSlot;
+
+EventSlot events[EVENT_QUEUE_SIZE];
+atomic_ulong event_tail;   // Next slot to fill (producers)
+unsigned long event_head;  // Next slot to read (renderer only)
+sem_t sem_events;          // Posted after every event: wakes the renderer
+
+// Frame buffer of the renderer: written with one write() per frame
+#define FRAME_SIZE (128 * 1024)
+char frame[FRAME_SIZE];
+size_t frame_len;
+
+// Thread functions
+void* dog_thread(void* arg);
+void* owner_thread(void* arg);
+void* render_thread(void* arg);
+
+void set_add(IndexSet* set, int position) {
+    slot[position] = set->count;
+    set->items[set->count++] = position;
+}
+
+// Removes the i-th item: the last one takes its place
+int set_remove_at(IndexSet* set, int i) {
+    int position = set->items[i];
+    int last = set->items[--set->count];
+    set->items[i] = last;
+    slot[last] = i;
+    return position;
+}
+
+// Per-thread random numbers (splitmix64): rand() shares one state between threads
+uint64_t next_random(uint64_t* state) {
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+// Random number in [0, n)
+int random_below(uint64_t* state, int n) {
+    return (int)(((next_random(state) >> 32) * (uint64_t)n) >> 32);
+}
+
+uint64_t random_seed(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_nsec ^ ((uint64_t)ts.tv_sec << 32) ^ (uint64_t)pthread_self();
+}
+
+void gate_init(Gate* gate, int available) {
+    pthread_mutex_init(&gate->lock, NULL);
+    pthread_cond_init(&gate->not_empty, NULL);
+    gate->sleeping = 0;
+    gate->signaled = 0;
+    atomic_init(&gate->available, available);
+    atomic_init(&gate->spin, sysconf(_SC_NPROCESSORS_ONLN) > 1 ? SPIN_MIN : 0);  // One CPU: spinning can't help
+}
+
+void gate_destroy(Gate* gate) {
+    pthread_mutex_destroy(&gate->lock);
+    pthread_cond_destroy(&gate->not_empty);
+}
+
+// Lock the gate once there is something to take. The other side is often just
+// about to put something, so look a few times before sleeping; the number of
+// looks doubles when that worked and halves when the thread slept anyway.
+void gate_enter(Gate* gate, Counters* counters) {
+    int budget = atomic_load_explicit(&gate->spin, memory_order_relaxed);
+    int looks = 0;
+    
+    while (looks < budget && atomic_load_explicit(&gate->available, memory_order_relaxed) == 0) {
+        cpu_relax();
+        looks++;
+    }
+    pthread_mutex_lock(&gate->lock);
+    counters->handoffs++;
+    if (atomic_load_explicit(&gate->available, memory_order_relaxed) > 0) {
+        if (looks > 0) {
+            counters->spins++;  // Found while spinning: a sleep saved
+            if (budget < SPIN_MAX)
+                atomic_store_explicit(&gate->spin, budget * 2, memory_order_relaxed);
+        }
+        return;
+    }
+    
+    counters->sleeps++;
+    gate->sleeping++;
+    while (atomic_load_explicit(&gate->available, memory_order_relaxed) == 0) {
+        pthread_cond_wait(&gate->not_empty, &gate->lock);
+        counters->wakeups++;
+        if (gate->signaled > 0) gate->signaled--;
+    }
+    gate->sleeping--;
+    if (budget > SPIN_MIN)
+        atomic_store_explicit(&gate->spin, budget / 2, memory_order_relaxed);
+}
+
+// Unlock the gate, waking ONE sleeper if something is left to take: whoever
+// wakes up takes a whole batch, and wakes the next one only if there is more.
+// A sleeper already signaled is not signaled again while it gets to run.
+void gate_leave(Gate* gate, Counters* counters) {
+    if (gate->sleeping > gate->signaled && atomic_load_explicit(&gate->available, memory_order_relaxed) > 0) {
+        pthread_cond_signal(&gate->not_empty);
+        gate->signaled++;
+        counters->signals++;
+    }
+    pthread_mutex_unlock(&gate->lock);
+}
+
+// Take up to max random clean spaces (waits for at least one); returns how many
+int take_clean(int* positions, int max, uint64_t* rng, Counters* counters) {
+    gate_enter(&clean_gate, counters);
+    int n = clean_set.count < max ? clean_set.count : max;
+    for (int i = 0; i < n; i++)
+        positions[i] = set_remove_at(&clean_set, random_below(rng, clean_set.count));
+    atomic_store_explicit(&clean_gate.available, clean_set.count, memory_order_relaxed);
+    gate_leave(&clean_gate, counters);
+    counters->items += n;
+    return n;
+}
+
+void put_clean(const int* positions, int n, Counters* counters) {
+    pthread_mutex_lock(&clean_gate.lock);
+    counters->handoffs++;
+    for (int i = 0; i < n; i++)
+        set_add(&clean_set, positions[i]);
+    atomic_store_explicit(&clean_gate.available, clean_set.count, memory_order_relaxed);
+    gate_leave(&clean_gate, counters);
+}
+
+// Take up to max dirty spaces, oldest first (waits for at least one); returns how many
+int take_dirty(int* positions, int max, Counters* counters) {
+    gate_enter(&dirty_gate, counters);
+    int available = atomic_load_explicit(&dirty_gate.available, memory_order_relaxed);
+    int n = available < max ? available : max;
+    for (int i = 0; i < n; i++) {
+        positions[i] = dirty_queue.items[dirty_queue.head];
+        dirty_queue.head = (dirty_queue.head + 1) % garden_size;
+    }
+    atomic_store_explicit(&dirty_gate.available, available - n, memory_order_relaxed);
+    gate_leave(&dirty_gate, counters);
+    counters->items += n;
+    return n;
+}
+
+void put_dirty(const int* positions, int n, Counters* counters) {
+    pthread_mutex_lock(&dirty_gate.lock);
+    counters->handoffs++;
+    for (int i = 0; i < n; i++) {
+        dirty_queue.items[dirty_queue.tail] = positions[i];
+        dirty_queue.tail = (dirty_queue.tail + 1) % garden_size;
+    }
+    atomic_fetch_add_explicit(&dirty_gate.available, n, memory_order_relaxed);
+    gate_leave(&dirty_gate, counters);
+}
+
+// Push an event (never blocks, unless 1024 events are waiting to be drawn)
+void push_event(EventType type, int who, int value) {
+    unsigned long pos = atomic_load_explicit(&event_tail, memory_order_relaxed);
+    EventSlot* slot;
+    
+    for (;;) {
+        slot = &events[pos & (EVENT_QUEUE_SIZE - 1)];
+        long diff = (long)(atomic_load_explicit(&slot->seq, memory_order_acquire) - pos);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&event_tail, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed))
+                break;
+        } else if (diff < 0) {
+            sched_yield();  // Full: let the renderer catch up
+            pos = atomic_load_explicit(&event_tail, memory_order_relaxed);
+        } else {
+            pos = atomic_load_explicit(&event_tail, memory_order_relaxed);
+        }
+    }
+    slot->event.type = type;
+    slot->event.who = who;
+    slot->event.value = value;
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+    sem_post(&sem_events);
+}
+
+// Take the oldest event; returns 0 if there is none (yet)
+int pop_event(Event* event) {
+    EventSlot* slot = &events[event_head & (EVENT_QUEUE_SIZE - 1)];
+    if (atomic_load_explicit(&slot->seq, memory_order_acquire) != event_head + 1) return 0;
+    *event = slot->event;
+    atomic_store_explicit(&slot->seq, event_head + EVENT_QUEUE_SIZE, memory_order_release);
+    event_head++;
+    return 1;
+}
+
+// Append text to the frame
+void frame_add(const char* format, int value) {
+    if (frame_len < FRAME_SIZE) {
+        int n = snprintf(frame + frame_len, FRAME_SIZE - frame_len, format, value);
+        if (n > 0) frame_len += (size_t)n < FRAME_SIZE - frame_len ? (size_t)n : FRAME_SIZE - frame_len - 1;
+    }
+}
+
+// "The dog" when there is one, "Dog 3" when there are more
+void frame_add_name(const char* alone, const char* numbered, int who, int many) {
+    if (many > 1) {
+        frame_add(numbered, who + 1);
+    } else {
+        frame_add(alone, 0);
+    }
+}
+
+// Write the frame to the terminal with as few write() calls as possible (one)
+void frame_flush() {
+    size_t done = 0;
+    while (done < frame_len) {
+        ssize_t n = write(STDOUT_FILENO, frame + done, frame_len - done);
+        if (n <= 0) break;
+        done += (size_t)n;
+    }
+    frame_len = 0;
+}
+
+// Append the garden state, from the renderer's own copy of it, to the frame
+void frame_add_garden(const int* view, int dirty) {
+    if (garden_size > PRINT_MAX) {
+        frame_add("Garden state: %d clean, ", garden_size - dirty);
+        frame_add("%d dirty\n", dirty);
+        return;
+    }
+    frame_add("Garden state: ", 0);
+    for (int i = 0; i < garden_size; i++) {
+        if (view[i] == 0) {
+            frame_add("🌱 ", 0);  // Clean space
+        } else {
+            frame_add("💩 ", 0);  // Dirty space
+        }
+    }
+    frame_add("\n", 0);
+}
+
+// Renderer thread: waits for events, takes all the pending ones at once
+// (coalescing them) and draws them as one frame
+void* render_thread(void* arg) {
+    int* view = calloc(garden_size, sizeof(int));  // Its own copy: never reads the garden
+    int dirty = 0, quit = 0;
+    Event event;
+    (void)arg;
+    if (!view) return NULL;
+    
+    while (!quit) {
+        sem_wait(&sem_events);
+        while (sem_trywait(&sem_events) == 0)
+            ;  // Everything posted so far is drawn in this frame
+        
+        int changed = 0;
+        while (pop_event(&event)) {
+            switch (event.type) {
+            case DOG_LOOKING:
+                frame_add_name("The dog", "Dog %d", event.who, n_dogs);
+                frame_add(" is looking for a place to make a mess... (waiting: %d seconds)\n", event.value);
+                break;
+            case DOG_MESS:
+                view[event.value] = 1;
+                dirty++;
+                changed = 1;
+                frame_add_name("The dog", "Dog %d", event.who, n_dogs);
+                frame_add(" has made a mess at position %d!\n", event.value);
+                break;
+            case DOG_DONE:
+                frame_add_name("The dog", "Dog %d", event.who, n_dogs);
+                frame_add(" has finished making messes and goes to sleep.\n", 0);
+                break;
+            case OWNER_LOOKING:
+                frame_add_name("The owner", "Owner %d", event.who, n_owners);
+                frame_add(" is looking for a mess to clean... (waiting: %d seconds)\n", event.value);
+                break;
+            case OWNER_CLEAN:
+                view[event.value] = 0;
+                dirty--;
+                changed = 1;
+                frame_add_name("The owner", "Owner %d", event.who, n_owners);
+                frame_add(" has cleaned position %d!\n", event.value);
+                break;
+            case OWNER_DONE:
+                frame_add_name("The owner", "Owner %d", event.who, n_owners);
+                frame_add(" has finished cleaning and goes to rest.\n", 0);
+                break;
+            case RENDER_QUIT:
+                quit = 1;
+                break;
+            }
+        }
+        if (changed) frame_add_garden(view, dirty);
+        frame_flush();
+    }
+    free(view);
+    return NULL;
+}
+
+// Dog thread
+void* dog_thread(void* arg) {
+    Worker* dog = (Worker*)arg;
+    uint64_t rng = random_seed();
+    int* positions = malloc(sizeof(int) * batch);
+    if (!positions) return NULL;
+    
+    for (int done = 0; done < dog->count; ) {
+        // Wait a bit before making a mess
+        if (!bench) {
+            int wait_time = random_below(&rng, 3) + 1;
+            push_event(DOG_LOOKING, dog->index, wait_time);
+            sleep(wait_time);
+        }
+        
+        // Take up to a batch of random clean spaces (waits for at least one)
+        int left = dog->count - done;
+        int n = take_clean(positions, left < batch ? left : batch, &rng, &dog->counters);
+        
+        // They are this dog's alone until handed to the owners: no lock needed
+        for (int i = 0; i < n; i++) {
+            garden[positions[i]] = 1;  // Dirty the space
+            if (!bench) push_event(DOG_MESS, dog->index, positions[i]);  // Drawn by the renderer
+        }
+        put_dirty(positions, n, &dog->counters);
+        done += n;
+    }
+    
+    if (!bench) push_event(DOG_DONE, dog->index, 0);
+    free(positions);
+    return NULL;
+}
+
+// Owner thread
+void* owner_thread(void* arg) {
+    Worker* owner = (Worker*)arg;
+    uint64_t rng = random_seed();
+    int* positions = malloc(sizeof(int) * batch);
+    if (!positions) return NULL;
+    
+    for (int done = 0; done < owner->count; ) {
+        // Wait a bit before cleaning
+        if (!bench) {
+            int wait_time = random_below(&rng, 2) + 1;
+            push_event(OWNER_LOOKING, owner->index, wait_time);
+            sleep(wait_time);
+        }
+        
+        // Take up to a batch of dirty spaces (waits for at least one)
+        int left = owner->count - done;
+        int n = take_dirty(positions, left < batch ? left : batch, &owner->counters);
+        
+        for (int i = 0; i < n; i++) {
+            garden[positions[i]] = 0;  // Clean the space
+            if (!bench) push_event(OWNER_CLEAN, owner->index, positions[i]);  // Drawn by the renderer
+        }
+        put_clean(positions, n, &owner->counters);
+        done += n;
+    }
+    
+    if (!bench) push_event(OWNER_DONE, owner->index, 0);
+    free(positions);
+    return NULL;
+}
+
+double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void add_counters(Counters* total, const Counters* c) {
+    total->items += c->items;
+    total->handoffs += c->handoffs;
+    total->sleeps += c->sleeps;
+    total->wakeups += c->wakeups;
+    total->signals += c->signals;
+    total->spins += c->spins;
+}
+
+int main(int argc, char* argv[]) {
+    pthread_t renderer;
+    
+    // -b, size of the garden, actions per dog, threads and batch from the command line
+    int arg = 1;
+    if (argc > arg && strcmp(argv[arg], "-b") == 0) {
+        bench = 1;
+        arg++;
+    }
+    if (argc > arg) garden_size = atoi(argv[arg]);
+    int actions = (argc > arg + 1) ? atoi(argv[arg + 1]) : 8;
+    if (argc > arg + 2) n_dogs = atoi(argv[arg + 2]);
+    if (argc > arg + 3) n_owners = atoi(argv[arg + 3]);
+    if (argc > arg + 4) batch = atoi(argv[arg + 4]);
+    if (garden_size <= 0 || actions < 0 || n_dogs <= 0 || n_owners <= 0 || batch <= 0 || argc > arg + 5) {
+        printf("USAGE: %s [-b] [GARDEN_SIZE [ACTIONS [DOGS [OWNERS [BATCH]]]]]\n", argv[0]);
+        return -1;
+    }
+    garden = malloc(sizeof(int) * garden_size);
+    slot = malloc(sizeof(int) * garden_size);
+    clean_set.items = malloc(sizeof(int) * garden_size);
+    dirty_queue.items = malloc(sizeof(int) * garden_size);
+    pthread_t* threads = malloc(sizeof(pthread_t) * (n_dogs + n_owners));
+    Worker* workers = calloc(n_dogs + n_owners, sizeof(Worker));
+    if (!garden || !slot || !clean_set.items || !dirty_queue.items || !threads || !workers) {
+        printf("Not enough memory for %d spaces\n", garden_size);
+        return -1;
+    }
+    
+    // Initialize the garden (all clean at the beginning)
+    for (int i = 0; i < garden_size; i++) {
+        garden[i] = 0;
+        set_add(&clean_set, i);
+    }
+    
+    if (!bench) {
+        frame_add("Initial garden state:\n", 0);
+        frame_add_garden(garden, 0);
+        frame_flush();
+    }
+    
+    // Initialize the gates and the renderer's semaphore
+    gate_init(&clean_gate, garden_size);     // All spaces are clean at the beginning
+    gate_init(&dirty_gate, 0);               // No dirty spaces at the beginning
+    sem_init(&sem_events, 0, 0);             // No events to draw yet
+    for (unsigned long i = 0; i < EVENT_QUEUE_SIZE; i++) {
+        atomic_init(&events[i].seq, i);      // Every slot free
+    }
+    
+    // Every dog makes ACTIONS messes; the owners share the cleaning evenly
+    long total = (long)actions * n_dogs;
+    for (int i = 0; i < n_dogs; i++) {
+        workers[i].index = i;
+        workers[i].count = actions;
+    }
+    for (int i = 0; i < n_owners; i++) {
+        workers[n_dogs + i].index = i;
+        workers[n_dogs + i].count = (int)(total / n_owners + (i < total % n_owners));
+    }
+    
+    // Create threads
+    if (!bench) pthread_create(&renderer, NULL, render_thread, NULL);
+    double start = now_seconds();
+    for (int i = 0; i < n_dogs + n_owners; i++) {
+        pthread_create(&threads[i], NULL, i < n_dogs ? dog_thread : owner_thread, &workers[i]);
+    }
+    
+    // Wait for threads to complete
+    for (int i = 0; i < n_dogs + n_owners; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    double seconds = now_seconds() - start;
+    if (!bench) {
+        push_event(RENDER_QUIT, 0, 0);  // Draw what is left, then stop
+        pthread_join(renderer, NULL);
+    }
+    
+    if (bench) {
+        // Every mess is handed over twice: dog -> owner, then back as a clean space
+        Counters sum = {0};
+        for (int i = 0; i < n_dogs + n_owners; i++) add_counters(&sum, &workers[i].counters);
+        long items = sum.items / 2;
+        printf("%d dogs, %d owners, batch %d: %ld messes in %.3f s, %.0f items/s\n",
+               n_dogs, n_owners, batch, items, seconds, seconds > 0 ? items / seconds : 0.0);
+        printf("per item: %.3f lock handoffs, %.4f wakeups, %.4f sleeps, %.4f signals "
+               "(%ld sleeps saved by spinning)\n",
+               items ? (double)sum.handoffs / items : 0.0, items ? (double)sum.wakeups / items : 0.0,
+               items ? (double)sum.sleeps / items : 0.0, items ? (double)sum.signals / items : 0.0,
+               sum.spins);
+    }
+    
+    // Every mess was cleaned: the whole garden is back in the clean set
+    int dirty = 0;
+    for (int i = 0; i < garden_size; i++) dirty += garden[i];
+    if (clean_set.count != garden_size || dirty != 0 || atomic_load(&dirty_gate.available) != 0) {
+        printf("Inconsistent garden: %d clean spaces out of %d, %d dirty\n", clean_set.count, garden_size, dirty);
+    }
+    
+    // Destroy the gates and the semaphore
+    gate_destroy(&clean_gate);
+    gate_destroy(&dirty_gate);
+    sem_destroy(&sem_events);
+    
+    free(garden);
+    free(slot);
+    free(clean_set.items);
+    free(dirty_queue.items);
+    free(threads);
+    free(workers);
+    
+    if (!bench) printf("Simulation completed!\n");
+    return 0;
+}
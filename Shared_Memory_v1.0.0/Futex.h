@@ -0,0 +1,60 @@
+/******************************************************************************/
+/*                                                                            */
+/*                                Futex Library                               */
+/*                                                                            */
+/* DESCRIPTION:                                                               */
+/* Thin wrapper around the Linux futex() system call. A futex is a 32-bit     */
+/* word in (possibly shared) memory: a process can sleep while the word holds */
+/* an expected value and another process can wake it up. Everything else      */
+/* (the fast path) is done with atomic instructions in userspace.             */
+/* The wrappers use process-shared futexes, so the word may live in a         */
+/* shared memory segment.                                                     */
+/*                                                                            */
+/* Copyright (c) 2026, Nico Fontani                                           */
+/* Creation Date: 19 Oct 2026                                                 */
+/*                                                                            */
+/* This code was developed by Nico Fontani. Its use and modification are      */
+/* permitted, provided that any changes are documented, and the author        */
+/* and date are updated to recognize each developer's contribution            */
+/* and maintain clear version tracking.                                       */
+/*                                                                            */
+/* Original Author: Nico Fontani                                              */
+/* Last Modified: 19 Oct 2026                                                 */
+/*                                                                            */
+/******************************************************************************/
+
+#ifndef __FUTEX_H
+#define __FUTEX_H
+
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+/* Hint to the CPU that we are busy-waiting */
+#if defined(__x86_64__) || defined(__i386__)
+#define cpu_relax() __builtin_ia32_pause()
+#elif defined(__aarch64__)
+#define cpu_relax() __asm__ __volatile__("yield")
+#else
+#define cpu_relax() ((void)0)
+#endif
+
+/* futex_wait()
+   RECEIVES: The futex word, the value it is expected to hold and an optional
+             relative timeout (NULL waits forever)
+   RETURNS: 0 when woken up, -1 with errno EAGAIN (the word had changed),
+            ETIMEDOUT or EINTR */
+int futex_wait(uint32_t* addr, uint32_t expected, const struct timespec* timeout) {
+    return syscall(SYS_futex, addr, FUTEX_WAIT, expected, timeout, NULL, 0);
+}
+
+/* futex_wake()
+   RECEIVES: The futex word and the maximum number of sleepers to wake
+   RETURNS: The number of processes woken up, -1 on error */
+int futex_wake(uint32_t* addr, int n_waiters) {
+    return syscall(SYS_futex, addr, FUTEX_WAKE, n_waiters, NULL, NULL, 0);
+}
+
+#endif  /* __FUTEX_H */
@@ -0,0 +1,148 @@
+/******************************************************************************/
+/*                                                                            */
+/*                              SHARED CHANNEL TEST                           */
+/*                                                                            */
+/* DESCRIPTION:                                                               */
+/* This program measures the shm_channel ring buffer between processes.       */
+/* It creates a channel in an unnamed shared memory segment, forks producer   */
+/* and consumer processes, sends a sequence of numbers through the channel    */
+/* and checks that every number arrived. It prints messages per second for    */
+/* the SPSC variant and for the MPMC variant with several processes.          */
+/*                                                                            */
+/* Copyright (c) 2026, Nico Fontani                                           */
+/* Creation Date: 19 Oct 2026                                                 */
+/*                                                                            */
+/* This code was developed by Nico Fontani. Its use and modification are      */
+/* permitted, provided that any changes are documented, and the author        */
+/* and date are updated to recognize each developer's contribution            */
+/* and maintain clear version tracking.                                       */
+/*                                                                            */
+/* Original Author: Nico Fontani                                              */
+/* Last Modified: 19 Oct 2026                                                 */
+/*                                                                            */
+/******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/wait.h>
+
+#include "shared.h"
+#include "shm_channel.h"
+
+#define CAPACITY 4096        // Slots in the ring
+#define STOP     UINT64_MAX  // Message telling a consumer to finish
+
+// Results written by the consumers
+typedef struct {
+    uint64_t received;
+    uint64_t sum;
+} Totals;
+
+double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Producer: sends the numbers p, p + n_prod, p + 2 * n_prod, ... below n_msgs
+void producer(ShmChannel* ch, int p, int n_prod, uint64_t n_msgs, size_t batch) {
+    uint64_t buf[256];
+    size_t k = 0;
+
+    for (uint64_t v = (uint64_t)p; v < n_msgs; v += (uint64_t)n_prod) {
+        buf[k++] = v;
+        if (k == batch) {
+            shm_channel_send_batch(ch, buf, k);
+            k = 0;
+        }
+    }
+    shm_channel_send_batch(ch, buf, k);
+}
+
+// Consumer: receives until it gets STOP, adds up what it got
+void consumer(ShmChannel* ch, Totals* totals, size_t batch) {
+    uint64_t buf[256];
+    uint64_t received = 0, sum = 0;
+    int stopped = 0;
+
+    while (!stopped) {
+        size_t k = shm_channel_recv_batch(ch, buf, batch);
+        for (size_t i = 0; i < k; i++) {
+            if (buf[i] != STOP) {
+                received++;
+                sum += buf[i];
+            } else if (!stopped) {
+                stopped = 1;
+            } else {
+                shm_channel_send(ch, &buf[i]);  // A STOP meant for another consumer
+            }
+        }
+    }
+    __atomic_fetch_add(&totals->received, received, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&totals->sum, sum, __ATOMIC_RELAXED);
+}
+
+// Run one configuration and print its throughput
+void run(int kind, int n_prod, int n_cons, uint64_t n_msgs, size_t batch) {
+    int fd;
+    size_t len = sizeof(Totals) + shm_channel_size(kind, CAPACITY, sizeof(uint64_t)) + SHM_CHANNEL_LINE;
+    char* mem = shared_create_anon(len, SHARED_POPULATE, &fd);
+    if (!mem) {
+        perror("shared_create_anon()");
+        exit(-1);
+    }
+    Totals* totals = (Totals*)mem;
+    ShmChannel* ch = shm_channel_init(mem + SHM_CHANNEL_LINE, kind, CAPACITY, sizeof(uint64_t));
+
+    fflush(stdout);  // Children must not inherit buffered output
+    double start = now_seconds();
+    for (int c = 0; c < n_cons; c++) {
+        if (!fork()) {
+            consumer(ch, totals, batch);
+            exit(0);
+        }
+    }
+    for (int p = 0; p < n_prod; p++) {
+        if (!fork()) {
+            producer(ch, p, n_prod, n_msgs, batch);
+            exit(0);
+        }
+    }
+
+    // When every producer is done, send one STOP per consumer
+    for (int p = 0; p < n_prod; p++)
+        wait(NULL);
+    uint64_t stop = STOP;
+    for (int c = 0; c < n_cons; c++)
+        shm_channel_send(ch, &stop);
+    for (int c = 0; c < n_cons; c++)
+        wait(NULL);
+    double elapsed = now_seconds() - start;
+
+    uint64_t expected = n_msgs * (n_msgs - 1) / 2;
+    printf("%s %dP/%dC batch %3zu: %10.0f msg/s  %s\n",
+           kind == SHM_CHANNEL_SPSC ? "SPSC" : "MPMC", n_prod, n_cons, batch,
+           n_msgs / elapsed,
+           (totals->received == n_msgs && totals->sum == expected) ? "OK" : "MISMATCH");
+
+    shared_unmap(mem, len);
+    close(fd);
+}
+
+int main(int argc, char* argv[]) {
+    uint64_t n_msgs = (argc > 1) ? strtoull(argv[1], NULL, 10) : 10000000;
+    size_t batch = (argc > 2) ? strtoul(argv[2], NULL, 10) : 64;
+    if (n_msgs == 0 || batch == 0 || batch > 256) {
+        printf("USAGE: %s [N_MESSAGES] [BATCH (1-256)]\n", argv[0]);
+        return -1;
+    }
+
+    run(SHM_CHANNEL_SPSC, 1, 1, n_msgs, 1);
+    run(SHM_CHANNEL_SPSC, 1, 1, n_msgs, batch);
+    run(SHM_CHANNEL_MPMC, 1, 1, n_msgs, 1);
+    run(SHM_CHANNEL_MPMC, 2, 2, n_msgs, batch);
+    run(SHM_CHANNEL_MPMC, 4, 4, n_msgs, batch);
+    return 0;
+}
@@ -4,8 +4,9 @@
 /*                                                                            */
 /* DESCRIZIONE:                                                               */
 /* This program demonstrates how to access shared memory and read a value    */
-/* from it. It finds the shared memory segment using a predefined key, and   */
-/* prints the value stored in it.                                             */
+/* from it. It attaches to the registry created by sharedTest (one key, one  */
+/* shmat()), looks the objects up by name and prints the value stored in it. */
+/* Then it follows the value, sleeping until the writer publishes a change.  */
 /*                                                                            */
 /* Copyright (c) 2024, Nico Fontani                                           */
 /* Data di creazione: 13 Nov 2024                                             */
@@ -16,33 +17,65 @@
 /* and maintain clear version tracking.                                       */
 /*                                                                            */
 /* Original Author: Nico Fontani                                              */
-/* Last Modified: 13 Nov 2024                                                 */
+/* Last Modified: 19 Oct 2026                                                 */
 /*                                                                            */
 /******************************************************************************/
 
-#include "shared.h"  // Include the shared memory header
+#include "shared.h"        // Include the shared memory header
+#include "shm_registry.h"  // Named objects in one segment
+#include "shm_notify.h"    // Change notification
 #include <stdio.h>
 #include <stdlib.h>
 #include <errno.h>
 #include <string.h>
 #include <unistd.h>
 
-#define SHM_KEY 4242  // Shared memory key
+#define REGISTRY_KEY 4250  // Registry key
+#define TIMEOUT_MS 1000    // Give up if the writer is silent this long
+
+// Objects in the registry: the same list as sharedTest.c, or attach fails
+const ShmRegistryObject objects[] = {
+    { "value",      sizeof(int) },
+    { "writer_pid", sizeof(pid_t) },
+    { "changed",    sizeof(shm_notify_t) },
+};
+#define N_OBJECTS (int)(sizeof(objects) / sizeof(objects[0]))
 
 void errore(int n, char* s);
 
 int main(void) {
     int shm_id;
     
-    // Find the shared memory using the 'shared_find' function
-    int* shared = (int*) shared_find(SHM_KEY, &shm_id);
-    if (!shared) {
-        errore(-1, "shared_find()");  // Error accessing shared memory
+    // Attach to the registry: fails if its layout is not the one we expect
+    ShmRegistry* reg = shm_registry_attach(REGISTRY_KEY, objects, N_OBJECTS, &shm_id);
+    if (!reg) {
+        errore(-1, "shm_registry_attach()");  // Error accessing shared memory
         return -1;
     }
+    int* shared = shm_registry_lookup(reg, "value", NULL);
+    pid_t* writer = shm_registry_lookup(reg, "writer_pid", NULL);
+    shm_notify_t* changed = shm_registry_lookup(reg, "changed", NULL);
 
     // Print the value read from shared memory
-    printf("Process %d: I read %d\n", getpid(), *shared);
+    // (the sequence is read first, so no later change can be missed)
+    uint32_t seen = shm_notify_read(changed);
+    int value = __atomic_load_n(shared, __ATOMIC_RELAXED);
+    printf("Process %d: I read %d (written by %d)\n", getpid(), value, (int)*writer);
+
+    // Follow the value until the writer sets it to -1, sleeping in between
+    unsigned long updates = 0, wakeups = 0;
+    while (value >= 0) {
+        uint32_t now = shm_wait_change(changed, seen, TIMEOUT_MS);
+        if (now == seen) {
+            printf("Process %d: no change for %d ms, giving up\n", getpid(), TIMEOUT_MS);
+            break;
+        }
+        updates += now - seen;
+        wakeups++;
+        seen = now;
+        value = __atomic_load_n(shared, __ATOMIC_RELAXED);
+    }
+    printf("Process %d: %lu updates seen in %lu wake-ups\n", getpid(), updates, wakeups);
 
     return 0;
 }
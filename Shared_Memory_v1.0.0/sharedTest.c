@@ -4,9 +4,9 @@
 /*                                                                            */
 /* DESCRIZIONE:                                                               */
 /* Questo programma dimostra come accedere e manipolare la memoria condivisa  */
-/* in un ambiente multi-processo. Utilizza un segmento di memoria condivisa   */
-/* identificato da una chiave predefinita (SHM_KEY), vi scrive un valore, e  */
-/* poi crea un processo figlio che leggerà tale valore.                       */
+/* in un ambiente multi-processo. Crea un registro (shm_registry.h) con una  */
+/* chiave predefinita (REGISTRY_KEY), vi scrive un valore negli oggetti       */
+/* registrati, e poi crea un processo figlio che leggerà tale valore.         */
 /*                                                                            */
 /* Copyright (c) 2024, Nico Fontani                                           */
 /* Data di creazione: 13 Nov 2024                                             */
@@ -18,7 +18,7 @@
 /* delle versioni.                                                            */
 /*                                                                            */
 /* Autore originale: Nico Fontani                                             */
-/* Data di ultima modifica: 13 Nov 2024                                        */
+/* Data di ultima modifica: 19 Oct 2026                                        */
 /*                                                                            */
 /******************************************************************************/
 
@@ -27,26 +27,43 @@
 #include <stdlib.h>
 #include <sys/wait.h>
 #include <errno.h>
-#include "shared.h"  // Include the shared memory library
+#include "shared.h"        // Include the shared memory library
+#include "shm_registry.h"  // Named objects in one segment
+#include "shm_notify.h"    // Change notification
 
-#define SHM_KEY 4242  // Shared memory key
+#define REGISTRY_KEY 4250  // Registry key (one key for every object)
+#define UPDATES 100000     // Values written after the first one
+#define BURST   1000       // Updates written without pausing
+
+// Objects in the registry: sharedReader.c must list the same ones
+const ShmRegistryObject objects[] = {
+    { "value",      sizeof(int) },
+    { "writer_pid", sizeof(pid_t) },
+    { "changed",    sizeof(shm_notify_t) },
+};
+#define N_OBJECTS (int)(sizeof(objects) / sizeof(objects[0]))
 
 int main(int argc, char* argv[]) {
     int shm_id;
     
-    // Find the shared memory using the 'shared_find' function
-    int* shared = (int*) shared_find(SHM_KEY, &shm_id);
-    if (!shared) {
-        perror("Error accessing shared memory");
+    // Create the registry holding every shared object
+    ShmRegistry* reg = shm_registry_create(REGISTRY_KEY, objects, N_OBJECTS, &shm_id);
+    if (!reg) {
+        perror("Error creating the shared registry");
         return -1;
     }
+    int* shared = shm_registry_lookup(reg, "value", NULL);
+    pid_t* writer = shm_registry_lookup(reg, "writer_pid", NULL);
+    shm_notify_t* changed = shm_registry_lookup(reg, "changed", NULL);
 
     // Write a value to shared memory and print it
     *shared = 42;
+    *writer = getpid();
     printf("{%d} I read %d.\n", getpid(), *shared);
+    fflush(stdout);  // The child must not inherit buffered output
 
     // Prepare the command to execute the shared reader
-    char* cmd[] = {"sharedReader", NULL};
+    char* cmd[] = {"./sharedReader", NULL};
     if (!fork()) {
         // Execute the command
         execvp(cmd[0], cmd);
@@ -54,6 +71,14 @@ int main(int argc, char* argv[]) {
         exit(-2); // Exit with an error code if execvp fails
     }
 
+    // Keep changing the value: the reader sleeps until we publish, and many
+    // updates published while it runs reach it as one wake-up. -1 means "done"
+    for (int v = 1; v <= UPDATES; v++) {
+        __atomic_store_n(shared, (v < UPDATES) ? 42 + v : -1, __ATOMIC_RELAXED);
+        shm_notify_publish(changed);
+        if (v % BURST == 0) usleep(100);
+    }
+
     // Wait for the child process to terminate
     int status;
     if (waitpid(-1, &status, 0) == -1) {
@@ -65,5 +90,7 @@ int main(int argc, char* argv[]) {
         printf("The child process terminated with status %d\n", WEXITSTATUS(status));
     }
 
+    // Remove the registry
+    shm_registry_remove(shm_id);
     return 0;
 }
@@ -0,0 +1,390 @@
+/******************************************************************************
+ *                                                                            *
+ *                                SHM_CHANNEL.H                               *
+ *                                                                            *
+ *                                                                            *
+ * This file provides a message channel between processes: a ring of         *
+ * fixed-size slots placed inside a shared memory segment (see shared.h).     *
+ * Two variants are available:                                                *
+ *  - SHM_CHANNEL_SPSC: one producer and one consumer process, wait-free;     *
+ *  - SHM_CHANNEL_MPMC: any number of producers and consumers, lock-free,     *
+ *    with a sequence number in every slot.                                   *
+ * Head and tail live on separate cache lines. Messages can be sent and       *
+ * received in batches, and the blocking calls sleep on a futex only when    *
+ * the channel is full (senders) or empty (receivers).                        *
+ *                                                                            *
+ *                                                                            *
+ * Copyright (c) 2026, Nico Fontani                                           *
+ * Creation Date: 19 Oct 2026                                                 *
+ *                                                                            *
+ * This code was developed by Nico Fontani. Its use and modification are      *
+ * permitted, provided that any changes are documented, and the author        *
+ * and date are updated to recognize each developer's contribution            *
+ * and maintain clear version tracking.                                       *
+ *                                                                            *
+ * Original Author: Nico Fontani                                              *
+ * Last Modified: 19 Oct 2026                                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+#include <sched.h>
+
+#include "Futex.h"
+
+#ifndef __SHM_CHANNEL_H
+#define __SHM_CHANNEL_H
+
+#define SHM_CHANNEL_MAGIC 0x4E464348u   /* "NFCH" */
+#define SHM_CHANNEL_SPSC  1             /* Single producer, single consumer */
+#define SHM_CHANNEL_MPMC  2             /* Multiple producers and consumers */
+#define SHM_CHANNEL_LINE  64            /* Cache line size */
+#define SHM_CHANNEL_SPIN  200           /* Retries before sleeping on the futex */
+#define SHM_CHANNEL_YIELD 1000          /* Spins on a slot before yielding the CPU */
+
+/* Channel header, followed by the slots. Everything lives in shared memory */
+typedef struct {
+    uint32_t magic;
+    uint32_t kind;           /* SHM_CHANNEL_SPSC or SHM_CHANNEL_MPMC */
+    uint32_t capacity;       /* Number of slots, a power of two */
+    uint32_t slot_size;      /* Bytes per message */
+    uint32_t stride;         /* Bytes per slot (MPMC: sequence + message) */
+
+    /* Producer side */
+    uint64_t tail __attribute__((aligned(SHM_CHANNEL_LINE)));
+    uint64_t cached_head;    /* SPSC: last head seen by the producer */
+
+    /* Consumer side */
+    uint64_t head __attribute__((aligned(SHM_CHANNEL_LINE)));
+    uint64_t cached_tail;    /* SPSC: last tail seen by the consumer */
+
+    /* Futex words for the blocking calls */
+    uint32_t not_empty __attribute__((aligned(SHM_CHANNEL_LINE)));
+    uint32_t empty_waiters;
+    uint32_t not_full __attribute__((aligned(SHM_CHANNEL_LINE)));
+    uint32_t full_waiters;
+
+    unsigned char slots[] __attribute__((aligned(SHM_CHANNEL_LINE)));
+} ShmChannel;
+
+/* Function prototypes */
+
+/* shm_channel_size()
+ * RECEIVES: The variant, the number of slots and the size of a message.
+ * RETURNS: The bytes of shared memory needed by the channel.
+ */
+size_t shm_channel_size(int kind, uint32_t capacity, uint32_t slot_size) {
+    size_t stride = ((kind == SHM_CHANNEL_MPMC ? sizeof(uint64_t) : 0) + slot_size + 7) & ~(size_t)7;
+    return sizeof(ShmChannel) + stride * capacity;
+}
+
+/* shm_channel_slot()
+ * RETURNS: The slot used by a ring position.
+ */
+unsigned char* shm_channel_slot(ShmChannel* ch, uint64_t pos) {
+    return ch->slots + (size_t)(pos & (ch->capacity - 1)) * ch->stride;
+}
+
+/* shm_channel_init()
+ * RECEIVES: Shared memory of at least shm_channel_size() bytes, the variant,
+ *           the number of slots (a power of two) and the size of a message.
+ * RETURNS: The channel, or NULL if the parameters are invalid.
+ */
+ShmChannel* shm_channel_init(void* mem, int kind, uint32_t capacity, uint32_t slot_size) {
+    ShmChannel* ch = mem;
+
+    if (!mem || capacity == 0 || (capacity & (capacity - 1)) != 0 || slot_size == 0 ||
+        (kind != SHM_CHANNEL_SPSC && kind != SHM_CHANNEL_MPMC))
+        return NULL;
+
+    memset(ch, 0, sizeof(ShmChannel));
+    ch->kind = (uint32_t)kind;
+    ch->capacity = capacity;
+    ch->slot_size = slot_size;
+    ch->stride = (uint32_t)((shm_channel_size(kind, capacity, slot_size) - sizeof(ShmChannel)) / capacity);
+
+    /* MPMC: slot i is free for the producer at position i */
+    if (kind == SHM_CHANNEL_MPMC) {
+        for (uint32_t i = 0; i < capacity; i++)
+            __atomic_store_n((uint64_t*)shm_channel_slot(ch, i), (uint64_t)i, __ATOMIC_RELAXED);
+    }
+
+    __atomic_store_n(&ch->magic, SHM_CHANNEL_MAGIC, __ATOMIC_RELEASE);
+    return ch;
+}
+
+/* shm_channel_attach()
+ * RECEIVES: Shared memory where another process initialized a channel.
+ * RETURNS: The channel, or NULL if the memory does not hold one.
+ */
+ShmChannel* shm_channel_attach(void* mem) {
+    ShmChannel* ch = mem;
+    if (!mem || __atomic_load_n(&ch->magic, __ATOMIC_ACQUIRE) != SHM_CHANNEL_MAGIC)
+        return NULL;
+    return ch;
+}
+
+/* shm_channel_spsc_send()
+ * Wait-free: copy up to n messages and publish them with one store.
+ */
+size_t shm_channel_spsc_send(ShmChannel* ch, const void* msgs, size_t n) {
+    uint64_t tail = __atomic_load_n(&ch->tail, __ATOMIC_RELAXED);
+    uint64_t space = ch->capacity - (tail - ch->cached_head);
+
+    if (space < n) {
+        ch->cached_head = __atomic_load_n(&ch->head, __ATOMIC_ACQUIRE);
+        space = ch->capacity - (tail - ch->cached_head);
+    }
+    if (n > space) n = (size_t)space;
+
+    for (size_t i = 0; i < n; i++)
+        memcpy(shm_channel_slot(ch, tail + i), (const char*)msgs + i * ch->slot_size, ch->slot_size);
+    if (n)
+        __atomic_store_n(&ch->tail, tail + n, __ATOMIC_RELEASE);
+    return n;
+}
+
+/* shm_channel_spsc_recv()
+ * Wait-free: copy up to max messages and free their slots with one store.
+ */
+size_t shm_channel_spsc_recv(ShmChannel* ch, void* msgs, size_t max) {
+    uint64_t head = __atomic_load_n(&ch->head, __ATOMIC_RELAXED);
+    uint64_t avail = ch->cached_tail - head;
+
+    if (avail < max) {
+        ch->cached_tail = __atomic_load_n(&ch->tail, __ATOMIC_ACQUIRE);
+        avail = ch->cached_tail - head;
+    }
+    if (max > avail) max = (size_t)avail;
+
+    for (size_t i = 0; i < max; i++)
+        memcpy((char*)msgs + i * ch->slot_size, shm_channel_slot(ch, head + i), ch->slot_size);
+    if (max)
+        __atomic_store_n(&ch->head, head + max, __ATOMIC_RELEASE);
+    return max;
+}
+
+/* shm_channel_slot_wait()
+ * Wait until a claimed slot reaches the expected sequence number. The peer
+ * that owns it is in the middle of a memcpy, unless it was preempted: then
+ * give it the CPU instead of spinning for a whole time slice.
+ */
+void shm_channel_slot_wait(unsigned char* slot, uint64_t expected) {
+    int spins = 0;
+    while (__atomic_load_n((uint64_t*)slot, __ATOMIC_ACQUIRE) != expected) {
+        if (++spins < SHM_CHANNEL_YIELD) {
+            cpu_relax();
+        } else {
+            sched_yield();
+            spins = 0;
+        }
+    }
+}
+
+/* shm_channel_mpmc_send()
+ * Lock-free for one message: claim the tail when its slot is free.
+ * A batch claims several positions with one compare-and-swap, then fills
+ * them (it may briefly wait for a consumer still copying out of a slot).
+ */
+size_t shm_channel_mpmc_send(ShmChannel* ch, const void* msgs, size_t n) {
+    uint64_t pos = __atomic_load_n(&ch->tail, __ATOMIC_RELAXED);
+
+    if (n == 0)
+        return 0;
+    if (n == 1) {
+        for (;;) {
+            uint64_t seq = __atomic_load_n((uint64_t*)shm_channel_slot(ch, pos), __ATOMIC_ACQUIRE);
+            int64_t diff = (int64_t)(seq - pos);
+            if (diff == 0) {
+                if (__atomic_compare_exchange_n(&ch->tail, &pos, pos + 1, 1,
+                                                __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                    break;
+            } else if (diff < 0) {
+                return 0;  /* Full */
+            } else {
+                pos = __atomic_load_n(&ch->tail, __ATOMIC_RELAXED);
+            }
+        }
+    } else {
+        for (;;) {
+            uint64_t head = __atomic_load_n(&ch->head, __ATOMIC_ACQUIRE);
+            if ((int64_t)(pos - head) < 0) {  /* Our tail is stale */
+                pos = __atomic_load_n(&ch->tail, __ATOMIC_RELAXED);
+                continue;
+            }
+            uint64_t space = (pos - head < ch->capacity) ? ch->capacity - (pos - head) : 0;
+            if (space == 0)
+                return 0;
+            if (n > space) n = (size_t)space;
+            if (__atomic_compare_exchange_n(&ch->tail, &pos, pos + n, 0,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                break;
+        }
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        unsigned char* slot = shm_channel_slot(ch, pos + i);
+        shm_channel_slot_wait(slot, pos + i);
+        memcpy(slot + sizeof(uint64_t), (const char*)msgs + i * ch->slot_size, ch->slot_size);
+        __atomic_store_n((uint64_t*)slot, pos + i + 1, __ATOMIC_RELEASE);
+    }
+    return n;
+}
+
+/* shm_channel_mpmc_recv()
+ * Same scheme as shm_channel_mpmc_send() on the consumer side.
+ */
+size_t shm_channel_mpmc_recv(ShmChannel* ch, void* msgs, size_t max) {
+    uint64_t pos = __atomic_load_n(&ch->head, __ATOMIC_RELAXED);
+
+    if (max == 0)
+        return 0;
+    if (max == 1) {
+        for (;;) {
+            uint64_t seq = __atomic_load_n((uint64_t*)shm_channel_slot(ch, pos), __ATOMIC_ACQUIRE);
+            int64_t diff = (int64_t)(seq - (pos + 1));
+            if (diff == 0) {
+                if (__atomic_compare_exchange_n(&ch->head, &pos, pos + 1, 1,
+                                                __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                    break;
+            } else if (diff < 0) {
+                return 0;  /* Empty */
+            } else {
+                pos = __atomic_load_n(&ch->head, __ATOMIC_RELAXED);
+            }
+        }
+    } else {
+        for (;;) {
+            uint64_t tail = __atomic_load_n(&ch->tail, __ATOMIC_ACQUIRE);
+            uint64_t avail = (tail > pos) ? tail - pos : 0;
+            if (avail == 0)
+                return 0;
+            if (max > avail) max = (size_t)avail;
+            if (__atomic_compare_exchange_n(&ch->head, &pos, pos + max, 0,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                break;
+        }
+    }
+
+    for (size_t i = 0; i < max; i++) {
+        unsigned char* slot = shm_channel_slot(ch, pos + i);
+        shm_channel_slot_wait(slot, pos + i + 1);
+        memcpy((char*)msgs + i * ch->slot_size, slot + sizeof(uint64_t), ch->slot_size);
+        __atomic_store_n((uint64_t*)slot, pos + i + ch->capacity, __ATOMIC_RELEASE);
+    }
+    return max;
+}
+
+/* shm_channel_wake()
+ * Wake the processes sleeping on a futex word, if there are any.
+ */
+void shm_channel_wake(uint32_t* word, uint32_t* waiters) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);  /* Pairs with the sleeper's check */
+    if (__atomic_load_n(waiters, __ATOMIC_RELAXED)) {
+        __atomic_fetch_add(word, 1, __ATOMIC_RELEASE);
+        futex_wake(word, INT_MAX);
+    }
+}
+
+/* shm_channel_try_send_batch()
+ * RECEIVES: The channel, n messages stored one after the other.
+ * RETURNS: The number of messages sent (0 if the channel is full).
+ */
+size_t shm_channel_try_send_batch(ShmChannel* ch, const void* msgs, size_t n) {
+    size_t sent = (ch->kind == SHM_CHANNEL_SPSC) ? shm_channel_spsc_send(ch, msgs, n)
+                                                 : shm_channel_mpmc_send(ch, msgs, n);
+    if (sent)
+        shm_channel_wake(&ch->not_empty, &ch->empty_waiters);
+    return sent;
+}
+
+/* shm_channel_try_recv_batch()
+ * RECEIVES: The channel, room for max messages.
+ * RETURNS: The number of messages received (0 if the channel is empty).
+ */
+size_t shm_channel_try_recv_batch(ShmChannel* ch, void* msgs, size_t max) {
+    size_t got = (ch->kind == SHM_CHANNEL_SPSC) ? shm_channel_spsc_recv(ch, msgs, max)
+                                                : shm_channel_mpmc_recv(ch, msgs, max);
+    if (got)
+        shm_channel_wake(&ch->not_full, &ch->full_waiters);
+    return got;
+}
+
+/* shm_channel_send_batch()
+ * RECEIVES: The channel, n messages stored one after the other.
+ * RETURNS: n, after all messages were sent (sleeps while the channel is full).
+ */
+size_t shm_channel_send_batch(ShmChannel* ch, const void* msgs, size_t n) {
+    size_t done = 0;
+    int spins = 0;
+
+    while (done < n) {
+        size_t k = shm_channel_try_send_batch(ch, (const char*)msgs + done * ch->slot_size, n - done);
+        if (k) {
+            done += k;
+            spins = 0;
+            continue;
+        }
+        if (++spins < SHM_CHANNEL_SPIN) {
+            cpu_relax();
+            continue;
+        }
+
+        /* Announce we are going to sleep, then check again before sleeping */
+        __atomic_fetch_add(&ch->full_waiters, 1, __ATOMIC_SEQ_CST);
+        uint32_t seen = __atomic_load_n(&ch->not_full, __ATOMIC_SEQ_CST);
+        k = shm_channel_try_send_batch(ch, (const char*)msgs + done * ch->slot_size, n - done);
+        if (!k)
+            futex_wait(&ch->not_full, seen, NULL);
+        __atomic_fetch_sub(&ch->full_waiters, 1, __ATOMIC_RELAXED);
+        done += k;
+        spins = 0;
+    }
+    return n;
+}
+
+/* shm_channel_recv_batch()
+ * RECEIVES: The channel, room for max messages.
+ * RETURNS: The number of messages received, at least 1 (sleeps while the
+ *          channel is empty).
+ */
+size_t shm_channel_recv_batch(ShmChannel* ch, void* msgs, size_t max) {
+    int spins = 0;
+
+    for (;;) {
+        size_t k = shm_channel_try_recv_batch(ch, msgs, max);
+        if (k)
+            return k;
+        if (++spins < SHM_CHANNEL_SPIN) {
+            cpu_relax();
+            continue;
+        }
+
+        __atomic_fetch_add(&ch->empty_waiters, 1, __ATOMIC_SEQ_CST);
+        uint32_t seen = __atomic_load_n(&ch->not_empty, __ATOMIC_SEQ_CST);
+        k = shm_channel_try_recv_batch(ch, msgs, max);
+        if (!k)
+            futex_wait(&ch->not_empty, seen, NULL);
+        __atomic_fetch_sub(&ch->empty_waiters, 1, __ATOMIC_RELAXED);
+        if (k)
+            return k;
+        spins = 0;
+    }
+}
+
+/* shm_channel_send() / shm_channel_recv()
+ * Blocking calls for a single message. RETURN 0.
+ */
+int shm_channel_send(ShmChannel* ch, const void* msg) {
+    shm_channel_send_batch(ch, msg, 1);
+    return 0;
+}
+
+int shm_channel_recv(ShmChannel* ch, void* msg) {
+    shm_channel_recv_batch(ch, msg, 1);
+    return 0;
+}
+
+#endif /* __SHM_CHANNEL_H */
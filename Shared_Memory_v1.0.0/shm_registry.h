@@ -0,0 +1,230 @@
+/******************************************************************************
+ *                                                                            *
+ *                               SHM_REGISTRY.H                               *
+ *                                                                            *
+ *                                                                            *
+ * This file lets cooperating processes share many named objects through a   *
+ * single shared memory segment (and a single IPC key). The segment starts    *
+ * with a header (magic, version, layout hash) and a directory of entries,   *
+ * each holding the name, offset and size of one object.                     *
+ * The creator lists the objects it wants; every other process attaches with *
+ * the same list and one shmat(), then looks the objects up by name.          *
+ * The layout hash is computed from that list: a process built with a         *
+ * different layout is refused instead of reading the wrong memory.           *
+ *                                                                            *
+ *                                                                            *
+ * Copyright (c) 2026, Nico Fontani                                           *
+ * Creation Date: 19 Oct 2026                                                 *
+ *                                                                            *
+ * This code was developed by Nico Fontani. Its use and modification are      *
+ * permitted, provided that any changes are documented, and the author        *
+ * and date are updated to recognize each developer's contribution            *
+ * and maintain clear version tracking.                                       *
+ *                                                                            *
+ * Original Author: Nico Fontani                                              *
+ * Last Modified: 19 Oct 2026                                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+
+#include "shared.h"
+
+#ifndef __SHM_REGISTRY_H
+#define __SHM_REGISTRY_H
+
+#define SHM_REGISTRY_MAGIC    "NFREGSTR"
+#define SHM_REGISTRY_VERSION  1
+#define SHM_REGISTRY_MAX      64        /* Objects in one registry */
+#define SHM_REGISTRY_NAME_LEN 32        /* Including the final '\0' */
+#define SHM_REGISTRY_ALIGN    64        /* Every object starts on a cache line */
+
+/* One object wanted by the caller */
+typedef struct {
+    const char* name;
+    size_t size;
+} ShmRegistryObject;
+
+/* One directory entry, in shared memory */
+typedef struct {
+    char name[SHM_REGISTRY_NAME_LEN];
+    uint64_t offset;          /* From the start of the segment */
+    uint64_t size;
+} ShmRegistryEntry;
+
+/* Start of the segment, followed by the objects */
+typedef struct {
+    char magic[8];            /* Written last: the registry is ready */
+    uint32_t version;
+    uint32_t count;
+    uint64_t layout_hash;
+    uint64_t total_size;
+    ShmRegistryEntry dir[SHM_REGISTRY_MAX];
+} __attribute__((aligned(SHM_REGISTRY_ALIGN))) ShmRegistry;
+
+/* shm_registry_layout_hash()
+ * RECEIVES: The list of objects and its length.
+ * RETURNS: A 64-bit FNV-1a hash of the version, names and sizes.
+ */
+uint64_t shm_registry_layout_hash(const ShmRegistryObject* objects, int n) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    uint64_t words[2];
+
+    words[0] = SHM_REGISTRY_VERSION;
+    words[1] = (uint64_t)n;
+    for (size_t i = 0; i < sizeof(words); i++)
+        hash = (hash ^ ((unsigned char*)words)[i]) * 0x100000001b3ull;
+    for (int k = 0; k < n; k++) {
+        for (const char* c = objects[k].name; *c; c++)
+            hash = (hash ^ (unsigned char)*c) * 0x100000001b3ull;
+        words[0] = objects[k].size;
+        for (size_t i = 0; i < sizeof(words[0]); i++)
+            hash = (hash ^ ((unsigned char*)words)[i]) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+/* shm_registry_size()
+ * RETURNS: The size of the segment holding the given objects, 0 if the list is invalid.
+ */
+size_t shm_registry_size(const ShmRegistryObject* objects, int n) {
+    size_t size = sizeof(ShmRegistry);
+
+    if (n < 0 || n > SHM_REGISTRY_MAX)
+        return 0;
+    for (int k = 0; k < n; k++) {
+        if (!objects[k].name || strlen(objects[k].name) >= SHM_REGISTRY_NAME_LEN)
+            return 0;
+        size += (objects[k].size + SHM_REGISTRY_ALIGN - 1) & ~(size_t)(SHM_REGISTRY_ALIGN - 1);
+    }
+    return size;
+}
+
+/* shm_registry_create()
+ * RECEIVES: IPC key, the list of objects and its length.
+ * RETURNS: The registry, with every object zeroed, or NULL on failure.
+ *          The shared memory ID is returned via reference.
+ */
+ShmRegistry* shm_registry_create(int ipc_key, const ShmRegistryObject* objects, int n, int* shm_id) {
+    size_t size = shm_registry_size(objects, n);
+    if (size == 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    if (size > INT_MAX) {     /* shared_create() takes an int */
+        errno = EFBIG;
+        return NULL;
+    }
+
+    ShmRegistry* reg = shared_create(ipc_key, (int)size, shm_id);
+    if (!reg || reg == (void*)-1)
+        return NULL;
+    memset(reg, 0, size);
+
+    uint64_t offset = sizeof(ShmRegistry);
+    for (int k = 0; k < n; k++) {
+        strcpy(reg->dir[k].name, objects[k].name);
+        reg->dir[k].offset = offset;
+        reg->dir[k].size = objects[k].size;
+        offset += (objects[k].size + SHM_REGISTRY_ALIGN - 1) & ~(uint64_t)(SHM_REGISTRY_ALIGN - 1);
+    }
+    reg->version = SHM_REGISTRY_VERSION;
+    reg->count = (uint32_t)n;
+    reg->layout_hash = shm_registry_layout_hash(objects, n);
+    reg->total_size = size;
+
+    /* Publish: the magic goes in after everything else */
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(reg->magic, SHM_REGISTRY_MAGIC, sizeof(reg->magic));
+    return reg;
+}
+
+/* shm_registry_detach()
+ * RECEIVES: The registry and its shared memory ID. The segment itself stays.
+ * RETURNS: 0 on success, 1 on failure (as shared_detach()).
+ */
+int shm_registry_detach(ShmRegistry* reg, int shm_id) {
+    return shared_detach(reg, shm_id);
+}
+
+/* shm_registry_attach()
+ * RECEIVES: IPC key and the list of objects the caller expects
+ *           (objects == NULL skips the layout check, for generic tools).
+ * RETURNS: The registry, or NULL (errno EPROTO) if it is not a registry, its
+ *          directory is corrupt or its layout differs from the expected one;
+ *          the segment is then detached again. The shared memory ID is
+ *          returned via reference.
+ */
+ShmRegistry* shm_registry_attach(int ipc_key, const ShmRegistryObject* objects, int n, int* shm_id) {
+    ShmRegistry* reg = shared_find(ipc_key, shm_id);
+    if (!reg || reg == (void*)-1)
+        return NULL;
+
+    if (memcmp(reg->magic, SHM_REGISTRY_MAGIC, sizeof(reg->magic)) != 0) {
+        fprintf(stderr, "shm_registry_attach(): key %d is not a registry\n", ipc_key);
+        shm_registry_detach(reg, *shm_id);
+        errno = EPROTO;
+        return NULL;
+    }
+    if (reg->version != SHM_REGISTRY_VERSION) {
+        fprintf(stderr, "shm_registry_attach(): registry on key %d has version %u, expected %d\n",
+                ipc_key, reg->version, SHM_REGISTRY_VERSION);
+        shm_registry_detach(reg, *shm_id);
+        errno = EPROTO;
+        return NULL;
+    }
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+    /* shm_registry_lookup() walks the directory up to count */
+    if (reg->count > SHM_REGISTRY_MAX) {
+        fprintf(stderr, "shm_registry_attach(): registry on key %d has %u objects, at most %d\n",
+                ipc_key, reg->count, SHM_REGISTRY_MAX);
+        shm_registry_detach(reg, *shm_id);
+        errno = EPROTO;
+        return NULL;
+    }
+
+    if (objects) {
+        uint64_t expected = shm_registry_layout_hash(objects, n);
+        if (reg->layout_hash != expected) {
+            fprintf(stderr, "shm_registry_attach(): layout mismatch on key %d "
+                    "(segment %016llx, expected %016llx)\n", ipc_key,
+                    (unsigned long long)reg->layout_hash, (unsigned long long)expected);
+            shm_registry_detach(reg, *shm_id);
+            errno = EPROTO;
+            return NULL;
+        }
+    }
+    return reg;
+}
+
+/* shm_registry_lookup()
+ * RECEIVES: The registry, the name of an object and where to store its size (may be NULL).
+ * RETURNS: A pointer to the object, or NULL if there is none with that name.
+ */
+void* shm_registry_lookup(ShmRegistry* reg, const char* name, size_t* size) {
+    for (uint32_t k = 0; k < reg->count; k++) {
+        if (strncmp(reg->dir[k].name, name, SHM_REGISTRY_NAME_LEN) == 0) {
+            if (size)
+                *size = reg->dir[k].size;
+            return (char*)reg + reg->dir[k].offset;
+        }
+    }
+    errno = ENOENT;
+    return NULL;
+}
+
+/* shm_registry_remove()
+ * RECEIVES: The shared memory ID of the registry.
+ * RETURNS: 0 on success, 1 on failure (as shared_remove()).
+ */
+int shm_registry_remove(int shm_id) {
+    return shared_remove(shm_id);
+}
+
+#endif /* __SHM_REGISTRY_H */